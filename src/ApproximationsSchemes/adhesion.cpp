@@ -190,8 +190,8 @@ void App_Var_AA::pot_corr()
 }
 
 void App_Var_AA::upd_pos()
-{// Leapfrog method for adhesion
+{// Symplectic integrator for adhesion
     m_impl->aa_convolution(*this);
-    auto kick_step = [&](){ kick_step_w_momentum(sim.cosmo, a_half(), da(), particles, app_field); };
-    stream_kick_stream(da(), particles, kick_step, sim.box_opt.mesh_num);
+    const Frozen_Force_Kick kick_step(app_field);
+    symplectic_step(sim, a(), da(), particles, kick_step, sim.box_opt.mesh_num);
 }
\ No newline at end of file
@@ -119,6 +119,12 @@ private:
 	std::vector<std::vector<Particle_x<FTYPE_t>>> par_pos;
 };
 
+/**
+ * @brief number of living approximations sharing FFTW threads, cleanup of FFTW invalidates plans of all of them
+ * (including plans owned by their members, e.g. chameleon solver) so it is done only by the last one
+ */
+size_t fftw_users = 0;
+
 //  ******************************
 }// * END OF ANONYMOUS NAMESPACE *
 //  ******************************
@@ -133,12 +139,12 @@ class App_Var<T>::Impl
 {
 public:
     // CONSTRUCTOR
-    Impl(const Sim_Param &sim, const std::string& app_short, const std::string& app_long):
-        step(0), print_every(sim.out_opt.print_every),
+    Impl(const Sim_Param &sim, const std::string& app_short, const std::string& app_long, const bool is_2lpt):
+        use_2lpt(is_2lpt || sim.integ_opt.ic_2lpt), keep_2lpt(is_2lpt), step(0), print_every(sim.out_opt.print_every),
         app_str(app_short), app_long(app_long), z_suffix_const("_" + app_short + "_"), out_dir_app(std_out_dir(app_short + "_run/", sim)),
         track(4, sim.box_opt.par_num_1d),
-        a(sim.integ_opt.b_in), a_out(sim.integ_opt.b_out), da(sim.integ_opt.db),
-        is_init_pwr_spec_0(false), is_init_vel_pwr_spec_0(false)
+        a(sim.integ_opt.b_in), a_out(sim.integ_opt.b_out), da(sim.integ_opt.db), db(sim.integ_opt.db),
+        is_init_pwr_spec_0(false), is_init_vel_pwr_spec_0(false), shell_cross(0), print_first(true)
     {
         // print simulation name
         print_sim_name();
@@ -157,6 +163,24 @@ public:
         return sizeof(FTYPE_t)*(APP.app_field[0].length*APP.app_field.size()+APP.power_aux[0].length*APP.power_aux.size());
     }
 
+    uint64_t alloc_mesh_vec_2(App_Var<T>& APP)
+    {
+        if (!use_2lpt) return 0;
+        APP.app_field_2.reserve(3);
+        for(size_t i = 0; i < 3; i++){
+            APP.app_field_2.emplace_back(APP.sim.box_opt.mesh_num);
+        }
+
+        return sizeof(FTYPE_t)*APP.app_field_2[0].length*APP.app_field_2.size();
+    }
+
+    void free_mesh_vec_2(App_Var<T>& APP)
+    {
+        if (!use_2lpt || keep_2lpt) return;
+        APP.app_field_2.clear();
+        APP.app_field_2.shrink_to_fit();
+    }
+
     uint64_t alloc_bin_spec(App_Var<T>& APP)
     {
         size_t bin_num = (size_t)ceil(log10(APP.sim.box_opt.mesh_num_pwr)*APP.sim.out_opt.bins_per_decade);
@@ -185,9 +209,10 @@ public:
     {
         const Sim_Param& sim = APP.sim; // get rid of 'APP.sim'
 
-        if (!FFTW_PLAN_OMP_INIT()){
+        if (!fftw_users && !FFTW_PLAN_OMP_INIT()){
             throw std::runtime_error("Errors during multi-thread initialization");
         }
+        ++fftw_users;
         FFTW_PLAN_OMP(sim.run_opt.nt);
         const size_t N_pot = sim.box_opt.mesh_num;
         const size_t N_pwr = sim.box_opt.mesh_num_pwr;
@@ -204,16 +229,20 @@ public:
 
     void set_init_pos(App_Var<T>& APP)
     {   
-        set_pert_pos(APP.sim, APP.sim.integ_opt.b_in, APP.particles, APP.app_field);
+        if (use_2lpt) set_pert_pos(APP.sim, APP.sim.integ_opt.b_in, APP.particles, APP.app_field, APP.app_field_2);
+        else set_pert_pos(APP.sim, APP.sim.integ_opt.b_in, APP.particles, APP.app_field);
     }
 
+    // 2LPT
+    const bool use_2lpt, keep_2lpt;
+
     void set_init_cond(App_Var<T>& APP)
     {
         /* Generating the right density distribution in k-space */	
         gen_rho_dist_k(APP.sim, APP.app_field[0], APP.p_F);
 
         /* Print input power spectrum (one realisation), before Zel`dovich push */
-        if (print_every) print_input_realisation(APP);
+        if (print_any(APP.sim.out_opt)) print_input_realisation(APP);
         
         /* Computing initial potential in k-space */
         gen_pot_k(APP.app_field[0], APP.power_aux[0]);
@@ -225,6 +254,9 @@ public:
         printf("Computing displacement in q-space...\n");
         fftw_execute_dft_c2r_triple(APP.p_B, APP.app_field);
 
+        /* Computing second-order displacement in q-space */
+        if (use_2lpt) gen_displ_2LPT(APP.app_field_2, APP.power_aux[0], APP.p_F, APP.p_B);
+
         /* Set initial positions of particles (with or without velocities)  */
         set_init_pos(APP);
     }
@@ -288,7 +320,7 @@ public:
     // CREATE WORKING DIRECTORY STRUCTURE
     void create_work_dir(const Out_Opt& out_opt)
     {
-        if (print_every)
+        if (print_any(out_opt))
         {
             if (out_opt.print_corr) create_dir(out_dir_app + "corr_func/");
             if (out_opt.print_par_pos) create_dir(out_dir_app + "par_cut/");
@@ -314,24 +346,73 @@ public:
 
     // INTEGRATION
     FTYPE_t a, a_out, da;
+    const FTYPE_t db; ///< nominal time-step
 
     void integration(App_Var<T>& APP)
     {
         print_init(APP); // WARNING: power_aux[0] is modified
+        if (APP.is_analytic() && !shell_cross) integration_analytic(APP);
+        else integration_steps(APP);
+        print_info(APP.sim);
+    }
+
+    void integration_steps(App_Var<T>& APP)
+    {
         while(integrate())
         {
             printf("\nStarting computing step with z = %.2f (a = %.3f)\n", z(), a);
             APP.upd_pos();
             track.update_track_par(APP.particles);
+            if (is_shell_crossed(APP)) a_out = a; // stop integration
             if (printing()) APP.print_output();
             upd_time();
         }
-        print_info(APP.sim);
+    }
+
+    // HYBRID SIMULATIONS
+    FTYPE_t shell_cross; ///< stop integration when fraction of shell-crossed particles exceeds this value (0 = never)
+    bool print_first; ///< print output at the beginning of integration
+
+    void set_handover(App_Var<T>& APP, const std::vector<T>& handover, const FTYPE_t a_begin)
+    {
+        if (APP.is_analytic()){
+            throw std::runtime_error("Analytic approximation (" + app_str + ") can be only the first stage of hybrid simulation!");
+        }
+        printf("Taking over particles at z = %.2f (a = %.3f)\n", 1/a_begin - 1, a_begin);
+        APP.particles = handover;
+        a = a_begin;
+        print_first = false; // already printed by the previous stage
+    }
+
+    bool is_shell_crossed(const App_Var<T>& APP) const
+    {
+        if (!shell_cross) return false;
+        const FTYPE_t frac = get_shell_cross_frac(APP.particles, APP.sim);
+        printf("Fraction of shell-crossed particles: %.2e\n", frac);
+        if (frac <= shell_cross) return false;
+        printf("Fraction of shell-crossed particles exceeded %.2e, stopping %s.\n", shell_cross, app_long.c_str());
+        return true;
+    }
+
+    void integration_analytic(App_Var<T>& APP)
+    {// positions depend only on time, jump from one output to the next
+        for (const FTYPE_t a_eval : get_a_eval())
+        {
+            printf("\nEvaluating approximation at z = %.2f (a = %.3f)\n", 1/a_eval - 1, a_eval);
+            da = a_eval - a;
+            a = a_eval;
+            step++;
+            APP.upd_pos();
+            track.update_track_par(APP.particles);
+            if (print_every || is_print_z()) APP.print_output();
+        }
+        da = 0; // integration finished
     }
 
 private:
     // PRIVATE PRINTING
     unsigned int print_every, step;
+    std::vector<FTYPE_t> a_print_z; ///< additional output times, time-steps are shortened to end at them
     Tracking track;
     Interp_obj pwr_spec_input;
 
@@ -344,9 +425,47 @@ private:
             << "\n" << std::string(app_long_upper.length(), '*') << "\n";
     }
 
+    bool print_any(const Out_Opt& out_opt) const
+    {
+        return print_every || !out_opt.print_z.empty();
+    }
+
+    void set_a_print_z(const Sim_Param& sim)
+    {// additional output times within the rest of the simulation
+        a_print_z.clear();
+        for (const FTYPE_t z_out : sim.out_opt.print_z)
+        {
+            const FTYPE_t a_z = 1/(z_out + 1);
+            if ((a_z > a) && (a_z <= a_out)) a_print_z.push_back(a_z);
+        }
+        std::sort(a_print_z.begin(), a_print_z.end());
+    }
+
+    bool is_print_z() const
+    {
+        return std::binary_search(a_print_z.begin(), a_print_z.end(), a);
+    }
+
+    std::vector<FTYPE_t> get_a_eval() const
+    {// times at which the time-stepping would print output, the last time-step and additional outputs
+        std::vector<FTYPE_t> a_eval(a_print_z);
+        FTYPE_t a_step = a, da_step = db;
+        size_t step_tmp = step;
+        while((a_step <= a_out) && (da_step > 0))
+        {
+            if (print_every ? ((step_tmp % print_every) == 0) or (a_step == a_out) : (a_step == a_out)) a_eval.push_back(a_step);
+            step_tmp++;
+            if ((a_out - a_step) < da_step) da_step = a_out - a_step;
+            a_step += da_step;
+        }
+        std::sort(a_eval.begin(), a_eval.end());
+        a_eval.erase(std::unique(a_eval.begin(), a_eval.end()), a_eval.end());
+        return a_eval;
+    }
+
     bool printing() const
     {
-        return print_every ? ((step % print_every) == 0) or (a == a_out) : false ;
+        return (print_every ? ((step % print_every) == 0) or (a == a_out) : false) or is_print_z();
     }
 
     void print_info(const Sim_Param& sim) const
@@ -422,7 +541,8 @@ private:
     {
         /* Setting initial (binned) power spectrum, WARNING: power_aux[0] is modified */
         track.update_track_par(APP.particles);
-        if (print_every) APP.print_output();
+        if (print_every && print_first) APP.print_output();
+        set_a_print_z(APP.sim);
         upd_time();
     }
 
@@ -436,10 +556,16 @@ private:
     }
 
     void upd_time()
-    {
+    {// the last time-step ends at 'a_out', time-steps over additional outputs end at them
         step++;
-        if ((a_out - a) < da) da = a_out - a;
-        a += da;
+        da = std::min(db, a_out - a);
+        const auto a_z = std::upper_bound(a_print_z.begin(), a_print_z.end(), a);
+        if ((a_z != a_print_z.end()) && (*a_z < a + da))
+        {
+            da = *a_z - a;
+            a = *a_z;
+        }
+        else a += da;
     }
 
 
@@ -450,11 +576,12 @@ private:
 };
 
 template <class T> 
-App_Var<T>::App_Var(const Sim_Param &sim, const std::string& app_short, const std::string& app_long):
-	m_impl(new Impl(sim, app_short, app_long)), sim(sim), dens_binned(500)
+App_Var<T>::App_Var(const Sim_Param &sim, const std::string& app_short, const std::string& app_long, const bool is_2lpt):
+	m_impl(new Impl(sim, app_short, app_long, is_2lpt)), sim(sim), dens_binned(500)
 {
     // EFFICIENTLY ALLOCATE MEMORY
     memory_alloc = m_impl->alloc_mesh_vec(*this); // app_field, power_aux
+    memory_alloc += m_impl->alloc_mesh_vec_2(*this); // app_field_2
     memory_alloc += m_impl->alloc_bin_spec(*this); // pwr_spec_binned, pwr_spec_binned_0, vel_pwr_spec_binned_0
     memory_alloc += m_impl->alloc_bin_corr(*this); // corr_func_binned
     memory_alloc += m_impl->alloc_particles(*this); // particles
@@ -473,7 +600,7 @@ App_Var<T>::~App_Var()
     FFTW_DEST_PLAN(p_B);
     FFTW_DEST_PLAN(p_F_pwr);
 	FFTW_DEST_PLAN(p_B_pwr);
-	FFTW_PLAN_OMP_CLEAN();
+	if (!--fftw_users) FFTW_PLAN_OMP_CLEAN();
 }
 
 template <class T> 
@@ -488,6 +615,9 @@ void App_Var<T>::run_simulation()
     // CIC correction of potential (if not overriden)
     pot_corr();
 
+    // second-order displacement field is not needed anymore (if not kept)
+    m_impl->free_mesh_vec_2(*this);
+
     // integration
     m_impl->integration(*this);
 
@@ -495,6 +625,35 @@ void App_Var<T>::run_simulation()
     m_impl->print_end();
 }
 
+template <class T> 
+FTYPE_t App_Var<T>::run_simulation(std::vector<T>& handover, const FTYPE_t a_begin, const FTYPE_t a_end, const FTYPE_t shell_cross)
+{
+    // print memory usage
+    print_mem(memory_alloc);
+
+    // set initial conditions, potential is the same for all stages (the same seed)
+    m_impl->set_init_cond(*this);
+
+    // CIC correction of potential (if not overriden)
+    pot_corr();
+
+    // second-order displacement field is not needed anymore (if not kept)
+    m_impl->free_mesh_vec_2(*this);
+
+    // continue with particles from the previous stage
+    if (!handover.empty()) m_impl->set_handover(*this, handover, a_begin);
+    m_impl->a_out = a_end;
+    m_impl->shell_cross = shell_cross;
+
+    // integration
+    m_impl->integration(*this);
+
+    // end of stage
+    m_impl->print_end();
+    handover = particles;
+    return m_impl->a;
+}
+
 template <class T> 
 void App_Var<T>::pot_corr()
 {
@@ -506,6 +665,12 @@ void App_Var<T>::pot_corr()
     fftw_execute_dft_c2r_triple(p_B, app_field);
 }
 
+template <class T> 
+bool App_Var<T>::is_analytic() const
+{
+    return false;
+}
+
 template <class T> 
 void App_Var<T>::print_output()
 {
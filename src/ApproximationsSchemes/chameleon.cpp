@@ -17,6 +17,8 @@
 #include "multigrid_solver.h"
 
 #include <algorithm>
+#include <limits>
+#include <omp.h>
 
 /*****************************//**
  * PRIVATE FUNCTIONS DEFINITIONS *
@@ -24,11 +26,28 @@
 namespace{
 
 /**
- * @brief accuracy of chameleon solver
+ * @brief accuracy of chameleon solver, storage and smoothing on all levels
  * @typedef CHI_PREC_t
  * 
  */
+#ifndef CHI_PRECISION
+#define CHI_PRECISION 2 // default double precision
+#endif
+
+#if CHI_PRECISION == 1
+typedef float CHI_PREC_t;
+#elif CHI_PRECISION == 2
 typedef double CHI_PREC_t;
+#else
+#error "Invalid value of CHI_PRECISION"
+#endif
+
+/**
+ * @brief finest level is refined in double precision, i.e. residual and update are evaluated in double
+ * @var CHI_REFINE
+ * 
+ */
+constexpr bool CHI_REFINE = sizeof(CHI_PREC_t) < sizeof(double);
 
 /**
  * @brief mass & chi in units of Planck mass
@@ -58,6 +77,14 @@ constexpr CHI_PREC_t MARK_CHI_BOUND_COND =  (CHI_PREC_t)-2;
  */
 constexpr CHI_PREC_t SWITCH_BIS_NEW = (CHI_PREC_t)0.1;
 
+/**
+ * @brief during warm start fix new local maxima of density where 'chi - CHI_MIN' of the previous solution is within this
+ * relative distance from its bulk value, i.e. screened
+ * @var SWITCH_SCREENED_WARM
+ * 
+ */
+constexpr CHI_PREC_t SWITCH_SCREENED_WARM = (CHI_PREC_t)0.1;
+
 /**
  * @brief minimum value of chameleon field, in chi_a units it is '0', in phi units it is '-1'
  * @var CHI_MIN
@@ -78,6 +105,13 @@ constexpr size_t CONVERGENCE_BI_STEPS = 5; ///< maximal number of steps inside b
 constexpr size_t CONVERGENCE_BI_STEPS_INIT = 3; ///< maximal number of steps inside bisection initialization method
 constexpr CHI_PREC_t CONVERGENCE_BI_DCHI = (CHI_PREC_t)1e-2; ///< stop bisection method when chi doesn`t chanege
 constexpr CHI_PREC_t CONVERGENCE_BI_L = (CHI_PREC_t)1e-2; ///< stop bisection method when residual below
+constexpr double CONVERGENCE_NEWTON_RES = 1e-10; ///< stop Newton`s method when (rms) residual decreased by this factor
+constexpr double CONVERGENCE_NEWTON_EPS = 10; ///< ...but not below this number of machine epsilons of the solver precision
+constexpr size_t CONVERGENCE_NEWTON_STEPS = 30; ///< maximal number of Newton`s steps
+constexpr size_t CONVERGENCE_NEWTON_BACKTRACK = 4; ///< maximal number of halvings of Newton`s step when residual increases
+constexpr CHI_PREC_t CONVERGENCE_NEWTON_MIN = (CHI_PREC_t)0.1; ///< Newton`s step can decrease 'chi - CHI_MIN' at most by this factor
+constexpr double CONVERGENCE_CG_RES = 1e-2; ///< stop conjugate gradients when residual of linear system decreased by this factor
+constexpr size_t CONVERGENCE_CG_STEPS = 50; ///< maximal number of steps of conjugate gradients
 /**@}*/
 
 /**
@@ -85,22 +119,26 @@ constexpr CHI_PREC_t CONVERGENCE_BI_L = (CHI_PREC_t)1e-2; ///< stop bisection me
  */
 using ES = MultiGridSolver<3, CHI_PREC_t>::Exit_Status;
 
+/**
+ * @brief copy data in Mesh 'N*N*(N+2)' onto Grid 'N*N*N' and back
+ * 
+ * Grid index 'iz + N*(iy + N*ix)' follows the memory layout of Mesh, the equation is isotropic so axes of Grid
+ * do not need to match axes of Mesh. Rows of 'N' contiguous points are copied without the padding.
+ */
 template<typename T>
 void transform_Mesh_to_Grid(const Mesh& mesh, Grid<3, T> &grid)
-{/* copy data in Mesh 'N*N*(N+2)' onto MultiGrid 'N*N*N' */
-    size_t ix, iy, iz;
-    const size_t N_tot = grid.get_Ntot();
+{
     const size_t N = grid.get_N();
-
     if (mesh.N != N) throw std::range_error("Mesh of a different size than Grid!");
 
-    #pragma omp parallel for private(ix, iy, iz)
-    for (size_t i = 0; i < N_tot; ++i)
+    T* const dst = grid.get_vec().data();
+    FTYPE_t const* const src = mesh.real();
+
+    #pragma omp parallel for
+    for (size_t row = 0; row < N*N; ++row)
     {
-        ix = i % N;
-        iy = i / N % N;
-        iz = i / (N*N);
-        grid[i] = mesh(ix, iy, iz);
+        #pragma omp simd
+        for (size_t iz = 0; iz < N; ++iz) dst[row*N + iz] = src[row*(N+2) + iz];
     }
 }
 
@@ -113,20 +151,18 @@ void transform_Mesh_to_MultiGrid(const Mesh& mesh, MultiGrid<3, T> &mltgrid)
 
 template<typename T>
 void transform_Grid_to_Mesh(Mesh& mesh, const Grid<3, T> &grid)
-{/* copy data in MultiGrid 'N*N*N' onto Mesh 'N*N*(N+2)' */
-    size_t ix, iy, iz;
-    const size_t N_tot = grid.get_Ntot();
+{
     const size_t N = grid.get_N();
-
     if (mesh.N != N) throw std::range_error("Mesh of a different size than Grid!");
 
-    #pragma omp parallel for private(ix, iy, iz)
-    for (size_t i = 0; i < N_tot; ++i)
+    FTYPE_t* const dst = mesh.real();
+    T const* const src = grid.get_vec().data();
+
+    #pragma omp parallel for
+    for (size_t row = 0; row < N*N; ++row)
     {
-        ix = i % N;
-        iy = i / N % N;
-        iz = i / (N*N);
-        mesh(ix, iy, iz) = grid[i];
+        #pragma omp simd
+        for (size_t iz = 0; iz < N; ++iz) dst[row*(N+2) + iz] = src[row*N + iz];
     }
 }
 
@@ -147,6 +183,108 @@ FTYPE_t min(const Grid<3, T> &grid){ return min(grid.get_vec()); }
 template<typename T>
 FTYPE_t min(const MultiGrid<3, T> &grid){ return min(grid.get_grid()); }
 
+/**
+ * @brief force '-grad(chi)' with respect to mesh coordinates by 4th order central differences
+ * 
+ * @param chi field on Grid with index 'iz + N*(iy + N*ix)', see \p transform_Mesh_to_Grid
+ * @param force three components on Mesh
+ */
+template<typename T>
+void get_force_fd(const Grid<3, T>& chi, std::vector<Mesh>& force)
+{
+    const size_t N = chi.get_N();
+    if (force[0].N != N) throw std::range_error("Mesh of a different size than Grid!");
+
+    T const* const f = chi.get_vec().data();
+    auto per = [N](size_t i, int d){ return (i + 2*N + d) % N; };
+    auto fd = [](T m2, T m1, T p1, T p2){ return (p2 - m2 + 8*(m1 - p1)) / 12; };
+
+    #pragma omp parallel for collapse(2)
+    for (size_t ix = 0; ix < N; ++ix)
+    {
+        for (size_t iy = 0; iy < N; ++iy)
+        {
+            const size_t row = (ix*N + iy)*N;
+            const size_t row_x[4] = {(per(ix, -2)*N + iy)*N, (per(ix, -1)*N + iy)*N, (per(ix, 1)*N + iy)*N, (per(ix, 2)*N + iy)*N};
+            const size_t row_y[4] = {(ix*N + per(iy, -2))*N, (ix*N + per(iy, -1))*N, (ix*N + per(iy, 1))*N, (ix*N + per(iy, 2))*N};
+            const size_t row_mesh = (ix*N + iy)*(N+2);
+
+            for (size_t iz = 0; iz < N; ++iz)
+            {
+                force[0][row_mesh + iz] = fd(f[row_x[0] + iz], f[row_x[1] + iz], f[row_x[2] + iz], f[row_x[3] + iz]);
+                force[1][row_mesh + iz] = fd(f[row_y[0] + iz], f[row_y[1] + iz], f[row_y[2] + iz], f[row_y[3] + iz]);
+                force[2][row_mesh + iz] = fd(f[row + per(iz, -2)], f[row + per(iz, -1)], f[row + per(iz, 1)], f[row + per(iz, 2)]);
+            }
+        }
+    }
+}
+
+/**
+ * @brief smooth field along one axis with [1,2,1]/4 kernel, in k-space 'cos^2(k/2)'
+ */
+void smooth_121(Mesh& field, const size_t axis)
+{
+    const size_t N = field.N;
+    const size_t stride[3] = {N*(N+2), N+2, 1};
+    const size_t s = stride[axis], s_1 = stride[(axis + 1) % 3], s_2 = stride[(axis + 2) % 3];
+
+    #pragma omp parallel
+    {
+        std::vector<FTYPE_t> line(N);
+
+        #pragma omp for collapse(2)
+        for (size_t j_1 = 0; j_1 < N; ++j_1)
+        {
+            for (size_t j_2 = 0; j_2 < N; ++j_2)
+            {
+                FTYPE_t* const f = field.real() + j_1*s_1 + j_2*s_2;
+                for (size_t i = 0; i < N; ++i) line[i] = f[i*s];
+                for (size_t i = 0; i < N; ++i) f[i*s] = (line[i ? i - 1 : N - 1] + 2*line[i] + line[i + 1 < N ? i + 1 : 0]) / 4;
+            }
+        }
+    }
+}
+
+template<typename T>
+double dot(const std::vector<T>& x, const std::vector<T>& y)
+{
+    double sum = 0;
+
+    #pragma omp parallel for reduction(+:sum)
+    for (size_t i = 0; i < x.size(); ++i) sum += x[i]*y[i];
+
+    return sum;
+}
+
+/**
+ * @brief indices 'i' with 'mask[i] == value' in ascending order, collected in parallel
+ */
+void get_indices(const std::vector<char>& mask, const char value, std::vector<size_t>& indices)
+{
+    const size_t size = mask.size();
+    std::vector<size_t> offset(omp_get_max_threads() + 1, 0);
+
+    #pragma omp parallel
+    {
+        const size_t t = omp_get_thread_num();
+        const size_t nt = omp_get_num_threads();
+        const size_t begin = size*t/nt, end = size*(t+1)/nt;
+        size_t num = 0;
+        for (size_t i = begin; i < end; ++i) num += (mask[i] == value);
+        offset[t+1] = num;
+
+        #pragma omp barrier
+        #pragma omp single
+        {
+            for (size_t j = 1; j <= nt; ++j) offset[j] += offset[j-1];
+            indices.resize(offset[nt]);
+        }
+
+        size_t k = offset[t];
+        for (size_t i = begin; i < end; ++i) if (mask[i] == value) indices[k++] = i;
+    }
+}
+
 /**
  * @class:	ChiSolver
  * @brief:	class to solve chameleon equations of motion
@@ -156,6 +294,8 @@ template<typename T>
 class ChiSolver : public MultiGridSolver<3, T>
 {
 public:
+    using ES = typename MultiGridSolver<3, T>::Exit_Status;
+
     // Parameters
     const T n;       ///< Hu-Sawicki paramater
     const T beta;   ///< Chameleon coupling constant
@@ -176,8 +316,39 @@ public:
     T m_dchi_stop;                  // if change in chi is small, stop halving
     T m_l_stop;                     // if residuum is small, stop halving
 
+    /**
+     * @brief points of one level split into fixed (deep-screened regime) and active ones
+     * 
+     * Fixed points are marked in overdensity by \p MARK_CHI_BOUND_COND, which serves as the mask inside rows of 'N'
+     * contiguous points along 'x'. Rows without active points are skipped altogether.
+     *
+     * Only passes of this class use the rows, i.e. \p ngs_sweep_rb and \p rms_residual, which run on the finest level
+     * in \p solve_rb and in convergence checks of Newton`s method. V-cycles of MultiGridSolver still smooth and restrict
+     * over all points of each level, fixed points are only restored afterwards by \p check_solution.
+     */
+    struct Active_Set
+    {
+        std::vector<size_t> fix_idx; ///< indices of fixed points
+        std::vector<T> fix_val; ///< values of the field at fixed points
+        std::vector<size_t> row_num_active; ///< number of active points in row 'iy + N*iz'
+    };
+
     // variables for checking solution in deep-screened regime, for each level
-    std::vector<std::map<size_t, T>> fix_vals; ///< <index, value>
+    std::vector<Active_Set> active_set;
+
+    // Newton-Krylov solver, linear multigrid of the Jacobian has its own hierarchy of grids down to 'N >= 4'
+    std::vector<size_t> jac_N; ///< size of grid at each level
+    std::vector<std::vector<T>> jac_diag, jac_x, jac_b, jac_r; ///< diagonal term of the Jacobian, solution, right-hand side, residual
+    std::vector<char> jac_fixed; ///< fixed points of the finest level
+    std::vector<T> cg_delta, cg_r, cg_z, cg_p, cg_q, chi_old; ///< vectors of conjugate gradients and previous solution
+
+    std::vector<double> chi_hi, chi_hi_old; ///< finest level in double precision for iterative refinement, see \p refine
+
+    std::vector<std::vector<char>> rb_bisect; ///< points of one row left for bisection, for each thread, see \p ngs_sweep_rb
+
+    // linear guess at coarser levels, 'lin_rho[level - 1]' with its plans, see \p alloc_linear
+    std::vector<Mesh> lin_rho;
+    std::vector<FFTW_PLAN_TYPE> lin_p_F, lin_p_B;
 
 
     ChiSolver(size_t N, unsigned int Nmin, const Sim_Param& sim, bool verbose = true) :
@@ -190,16 +361,25 @@ public:
             // beta*rho_m,0 / (Mpl*chi_0) + computing units [Mpc/h]; additional a^(-3 -3/(1-n)) at each timestep
             phi_prefactor*pow(sim.box_opt.box_size ,2) / sim.chi_opt.phi
         ),
-        fix_vals(this->get_Nlevel())
+        active_set(this->get_Nlevel())
         {
             if ((n <= 0) || (n >= 1) || (chi_0 <= 0)) throw std::out_of_range("invalid values of chameleon power-law potential parameters");
         }
 
     ChiSolver(size_t N, const Sim_Param& sim, bool verbose = true) : ChiSolver(N, 2, sim, verbose) {}
 
+    ChiSolver(const ChiSolver&) = delete; ///< owns FFTW plans
+    ChiSolver& operator=(const ChiSolver&) = delete;
+
+    ~ChiSolver()
+    {
+        for (FFTW_PLAN_TYPE p : lin_p_F) FFTW_DEST_PLAN(p);
+        for (FFTW_PLAN_TYPE p : lin_p_B) FFTW_DEST_PLAN(p);
+    }
+
     T chi_a(T a) const
     {
-        return chi_0*pow(a, 3/(1-n));
+        return chi_0*std::pow(a, 3/(1-n));
     }
 
     T chi_force_units(T a) const
@@ -249,44 +429,111 @@ public:
 
     void set_time(T a, const Cosmo_Param& cosmo)
     {
-        chi_prefactor = chi_prefactor_0*pow(a, -3.*(2.-n)/(1.-n));
+        chi_prefactor = chi_prefactor_0*std::pow(a, -3.*(2.-n)/(1.-n));
     }
 
     T get_chi_prefactor() const { return chi_prefactor; }
     T get_phi_prefactor() const { return phi_prefactor; }
 
-    T  l_operator(const T chi_i, const size_t level, const std::vector<size_t>& index_list, const bool addsource, const T h) const 
-    {/* The dicretized equation L(phi) */
-        // Solution and pde-source grid at current level
+    /**
+     * @brief everything the discretized equation needs at one point of 7-point stencil except the field itself
+     * 
+     * @tparam U arithmetic type, 'T' or 'double' for refinement of the finest level
+     */
+    template<typename U>
+    struct Stencil_U
+    {
+        U nb_sum; ///< sum of the field at 6 neighbouring points
+        U rho;    ///< overdensity
+        U source; ///< source term arising from restricting the equation down to the lower level
+        U h2_inv; ///< 1/h^2
+    };
+    using Stencil = Stencil_U<T>;
+
+    Stencil get_stencil(const size_t level, const std::vector<size_t>& index_list, const bool addsource, const T h) const
+    {
         const size_t i = index_list[0];
         T const* const chi = this->get_y(level); // solution
-        const T rho = this->get_external_field(level, 0)[i];
-        
+        Stencil st;
+        st.nb_sum = 0;
+        for(auto it = index_list.begin() + 1; it < index_list.end(); ++it) st.nb_sum += chi[*it];
+        st.rho = this->get_external_field(level, 0)[i];
+        st.source = (level > 0 && addsource) ? this->get_multigrid_source(level, i) : 0;
+        st.h2_inv = 1/(h*h);
+        return st;
+    }
+
+    template<typename U>
+    static U nb_sum(U const* const chi, const size_t i, const size_t N)
+    {/* sum over neighbours of 'i = ix + N*(iy + N*iz)' computed arithmetically with periodic wrap */
+        const size_t ix = i % N, iy = i / N % N, iz = i / (N*N);
+        return chi[i - ix + (ix ? ix - 1 : N - 1)] + chi[i - ix + (ix + 1 < N ? ix + 1 : 0)]
+             + chi[i + ((iy ? iy - 1 : N - 1) - iy)*N] + chi[i + ((iy + 1 < N ? iy + 1 : 0) - iy)*N]
+             + chi[i + ((iz ? iz - 1 : N - 1) - iz)*N*N] + chi[i + ((iz + 1 < N ? iz + 1 : 0) - iz)*N*N];
+    }
+
+    /**
+     * @brief offsets of one row of 'N' contiguous points along 'x' and of its neighbouring rows, with periodic wrap
+     */
+    struct Row
+    {
+        size_t row, ym, yp, zm, zp;
+
+        Row(const size_t r, const size_t N)
+        {/* row 'r = iy + N*iz' */
+            const size_t iy = r % N, iz = r / N;
+            row = N*r;
+            ym = N*((iy ? iy - 1 : N - 1) + N*iz);
+            yp = N*((iy + 1 < N ? iy + 1 : 0) + N*iz);
+            zm = N*(iy + N*(iz ? iz - 1 : N - 1));
+            zp = N*(iy + N*(iz + 1 < N ? iz + 1 : 0));
+        }
+
+        template<typename U>
+        U nb_sum(U const* const chi, const size_t ix, const size_t N) const
+        {
+            return chi[row + (ix ? ix - 1 : N - 1)] + chi[row + (ix + 1 < N ? ix + 1 : 0)]
+                 + chi[ym + ix] + chi[yp + ix] + chi[zm + ix] + chi[zp + ix];
+        }
+    };
+
+    Stencil get_stencil(const size_t level, const size_t i, const bool addsource) const
+    {
+        const size_t N = this->get_N(level);
+        Stencil st;
+        st.nb_sum = nb_sum(this->get_y(level), i, N);
+        st.rho = this->get_external_field(level, 0)[i];
+        st.source = (level > 0 && addsource) ? this->get_multigrid_source(level, i) : 0;
+        st.h2_inv = T(N*N);
+        return st;
+    }
+
+    template<typename U>
+    U l_point(const U chi_i, const Stencil_U<U>& st) const
+    {/* The dicretized equation L(phi) */
         // do not change values in screened regions
-        if (rho == MARK_CHI_BOUND_COND) return 0;
+        if (st.rho == MARK_CHI_BOUND_COND) return 0;
 
         // The right hand side of the PDE 
-        T source = (1 + rho - pow(chi_i - CHI_MIN, n - 1)) * chi_prefactor;
-
-        // Compute the standard kinetic term [D^2 phi] (in 1D this is phi''_i =  phi_{i+1} + phi_{i-1} - 2 phi_{i} )
-        T kinetic = -2*chi_i*3; // chi, '-2*3' is factor in 3D discrete laplacian
-        // go through all surrounding points
-        for(auto it = index_list.begin() + 1; it < index_list.end(); ++it) kinetic += chi[*it];
+        const U source = (1 + st.rho - std::pow(chi_i - CHI_MIN, U(n) - 1)) * chi_prefactor + st.source;
 
-        // source term arising rom restricting the equation down to the lower level
-        if( level > 0 && addsource ) source += this->get_multigrid_source(level, i);
+        // The discretized equation of motion L_{ijk...}(phi) = 0, '-2*3' is factor in 3D discrete laplacian
+        return (st.nb_sum - 2*3*chi_i)*st.h2_inv - source;
+    }
 
-        // The discretized equation of motion L_{ijk...}(phi) = 0
-        return kinetic/(h*h) - source;
+    template<typename U>
+    U newton_step(const U chi_i, const Stencil_U<U>& st, U& l) const
+    {/* Newton`s correction -l/dl, 'pow' is shared by L(phi) and its differential */
+        const U x = chi_i - CHI_MIN;
+        const U pow_x = std::pow(x, U(n) - 2);
+        l = (st.nb_sum - 2*3*chi_i)*st.h2_inv - ((1 + st.rho - pow_x*x) * chi_prefactor + st.source);
+        const U dl = -2*3*st.h2_inv - chi_prefactor*(1-n)*pow_x;
+        return -l/dl;
     }
 
     T  l_operator(const size_t level, const std::vector<size_t>& index_list, const bool addsource, const T h) const override
     {/* The dicretized equation L(phi) */
-        // Solution and pde-source grid at current level
-        const size_t i = index_list[0];
-        T const* const chi = this->get_y(level); // solution
-        const T chi_i = chi[i];
-        return l_operator(chi_i, level, index_list, addsource, h);
+        return l_point(this->get_y(level)[index_list[0]], get_stencil(level, index_list, addsource, h));
     }
 
     // Differential of the L operator: dL_{ijk...}/dphi_{ijk...}
@@ -296,7 +543,7 @@ public:
         const T chi = this->get_y(level)[ index_list[0] ];
 
         // Derivative of source
-        const T dsource = chi_prefactor*(1-n)*pow(chi - CHI_MIN, n-2);
+        const T dsource = chi_prefactor*(1-n)*std::pow(chi - CHI_MIN, n-2);
 
         // Derivative of kinetic term
         const T dkinetic = -2.0*3;
@@ -304,8 +551,8 @@ public:
         return dkinetic/(h*h) - dsource;
     }
 
-    bool find_opposite_l_sign(const T f1, const T l1, T df, T& f2, T& l2, const size_t level, const std::vector<size_t>& index_list, const T h) const
-    {/* find such 'f2' that 'l_operator(f2)' has opposite sign than l1
+    bool find_opposite_l_sign(const T f1, const T l1, T df, T& f2, T& l2, const Stencil& st) const
+    {/* find such 'f2' that 'l_point(f2)' has opposite sign than l1
         use df as a guess in which direction to be looking */
         f2 = f1;
         for (size_t j = 0; j < CONVERGENCE_BI_STEPS_INIT; ++j)
@@ -313,13 +560,10 @@ public:
             f2 += df;
             if (f2 <= CHI_MIN)
             {
-                const size_t i = index_list[0];
-                const T rho = this->get_external_field(level, 0)[i];
-
-                f2 = chi_min(rho);
+                f2 = chi_min(st.rho);
                 j = CONVERGENCE_BI_STEPS_INIT;//< end of loop but first check for an improvement
             }
-            l2 = l_operator(f2, level, index_list, true, h);
+            l2 = l_point(f2, st);
             if (l1*l2 <= 0) return true;
         }
         return false;
@@ -330,14 +574,14 @@ public:
         return ((std::abs(l_new) < m_l_stop) || (std::abs(df_new) < m_dchi_stop));
     }
 
-    T bisection_step(T& f1, T& l1, T& f2, T& l2, const size_t level, const std::vector<size_t>& index_list, const T h) const
-    {/* given 'f1' and 'f2' with different signs of l_operator(f_i) perform one step of bisection:
+    T bisection_step(T& f1, T& l1, T& f2, T& l2, const Stencil& st) const
+    {/* given 'f1' and 'f2' with different signs of l_point(f_i) perform one step of bisection:
         f_new = (f1 + f2) / 2
-        change whichever l_operator(f_i) has the same sign as l_operator(f_new)
+        change whichever l_point(f_i) has the same sign as l_point(f_new)
         return value indicates convergence -- 0 (unphysical for chameleon) not, otherwise yes*/
 
         const T f_new = (f1 + f2) / 2;
-        const T l_new = l_operator(f_new, level, index_list, true, h);
+        const T l_new = l_point(f_new, st);
 
         if (check_bisection_convergence(f2 - f_new, l_new)) return f_new;
 
@@ -353,16 +597,16 @@ public:
         return CHI_MIN;
     }
 
-    T bisection(T f1, T l1, const T df, const size_t level, const std::vector<size_t>& index_list, const T h) const
-    {/* initialize bisection solver -- find two values with opposite value of l_operator -- and start iterating */
+    T bisection(T f1, T l1, const T df, const Stencil& st) const
+    {/* initialize bisection solver -- find two values with opposite value of l_point -- and start iterating */
         T f_new, f2, l2;
 
         // get initial guess -- return when failed
-        if (!find_opposite_l_sign(f1, l1, df, f2, l2, level, index_list, h)) return f2;
+        if (!find_opposite_l_sign(f1, l1, df, f2, l2, st)) return f2;
 
         // iterate
         for (size_t i = 0; i < m_max_bisection_steps; ++i){
-            f_new = bisection_step(f1, l1, f2, l2, level, index_list, h);
+            f_new = bisection_step(f1, l1, f2, l2, st);
             if (f_new != CHI_MIN)
             {
                 return f_new;
@@ -373,47 +617,241 @@ public:
         return f1;
     }
 
-    
+    T upd_point(const T f, const Stencil& st) const
+    {/* if df is large, try bisection, otherwise Newton`s method */
+        // do not change values in screened regions
+        if (st.rho == MARK_CHI_BOUND_COND) return f;
+
+        T l;
+        const T df = newton_step(f, st, l);
+
+        static_assert((SWITCH_BIS_NEW < 1), "Newton`s method cannot be allowed with negative values. Adjust 'SWITCH_BIS_NEW < 1'.");
+
+        return std::abs(df/(f - CHI_MIN)) < SWITCH_BIS_NEW ? f + df : bisection(f, l, df / 2, st);
+    }
+
     T upd_operator(const T f, const size_t level, const std::vector<size_t>& index_list, const T h) const override
     {/* Method for updating solution:
         if df is large, try bisection, otherwise Newton`s method
         try Newton`s method and check for unphysical values */
-        T l  =  l_operator(level, index_list, true, h);
-        T dl = dl_operator(level, index_list, h);
-        T df = -l/dl;
-        T df_rel = std::abs(df/(f - CHI_MIN));
-
-        static_assert((SWITCH_BIS_NEW < 1), "Newton`s method cannot be allowed with negative values. Adjust 'SWITCH_BIS_NEW < 1'.");
-
-        return df_rel < SWITCH_BIS_NEW ? f + df : bisection(f, l, df / 2, level, index_list, h);
+        return upd_point(f, get_stencil(level, index_list, true, h));
     }
 
     void correct_sol(Grid<3,T>& f, const Grid<3,T>& corr, const size_t level) override
     {/* Method for correcting solution when going up,
-        check for unphysical values */
+        check for unphysical values, values in screened regions do not change */
 
-        const size_t Ntot  = f.get_Ntot();
-        const T * const rho = this->get_external_field(level, 0);
+        T const* const rho = this->get_external_field(level, 0); // overdensity
+        const size_t N_tot = this->get_Ntot(level);
 
-        // bisection variables
-        const size_t N = this->get_N(level);
-        const T h = 1.0/T( N );
-        std::vector<size_t> index_list;
-        
-        #pragma omp parallel for private(index_list)
-        for(size_t i = 0; i < Ntot; i++)
+        #pragma omp parallel for
+        for(size_t i = 0; i < N_tot; i++)
         {
-            // do not change values in screened regions
             if (rho[i] == MARK_CHI_BOUND_COND) continue;
-            else if (std::abs(corr[i]/(f[i] - CHI_MIN)) < SWITCH_BIS_NEW) f[i] += corr[i];
+            if (std::abs(corr[i]/(f[i] - CHI_MIN)) < SWITCH_BIS_NEW) f[i] += corr[i];
             else{
-                this->get_neighbor_gridindex(index_list, i, N);
-                T l =  l_operator(level, index_list, true, h);
-                f[i] = bisection(f[i], l, corr[i] / 2, level, index_list, h);
+                const Stencil st = get_stencil(level, i, true);
+                f[i] = bisection(f[i], l_point(f[i], st), corr[i] / 2, st);
             }   
         }
     }
 
+    /**
+     * @brief one sweep of nonlinear Gauss-Seidel in red-black ordering at given level
+     * 
+     * Points of one colour depend only on points of the other colour, each row of one colour is therefore updated
+     * in one vectorized pass of Newton`s method with contiguous neighbouring rows. Points with too large correction
+     * are left for bisection in a second pass. Fixed points are masked out and rows without active points are skipped.
+     * 
+     * The sweep is used only by \p solve_rb, i.e. on the finest level after Newton`s method or multigrid when the field
+     * is stored in double. MultiGridSolver does not expose its Gauss-Seidel sweep, V-cycles therefore still smooth
+     * point by point through \p upd_operator and gain nothing from this kernel.
+     */
+    void ngs_sweep_rb(const size_t level)
+    {
+        if (level) ngs_sweep_rb<true>(level);
+        else ngs_sweep_rb<false>(level);
+    }
+
+    template<bool addsource>
+    void ngs_sweep_rb(const size_t level)
+    {
+        T* const chi = this->get_y(level); // solution
+        T const* const rho = this->get_external_field(level, 0); // overdensity
+        const size_t N = this->get_N(level);
+        const T h2_inv = T(N*N);
+        size_t const* const row_num_active = active_set[level].row_num_active.data();
+
+        rb_bisect.resize(omp_get_max_threads());
+        for (auto& bisect : rb_bisect) if (bisect.size() < N) bisect.resize(N);
+
+        for (size_t colour = 0; colour < 2; ++colour)
+        {
+            #pragma omp parallel
+            {
+                char* const bisect = rb_bisect[omp_get_thread_num()].data();
+
+                #pragma omp for schedule(static)
+                for (size_t r = 0; r < N*N; ++r)
+                {
+                    if (!row_num_active[r]) continue;
+                    const Row rw(r, N);
+                    const size_t x_0 = (r % N + r / N + colour) % 2;
+                    const size_t num_x = (N - x_0 + 1) / 2;
+                    bool any_bisect = false;
+
+                    #pragma omp simd reduction(||:any_bisect)
+                    for (size_t k = 0; k < num_x; ++k)
+                    {
+                        const size_t ix = x_0 + 2*k;
+                        const size_t i = rw.row + ix;
+                        Stencil st;
+                        st.nb_sum = rw.nb_sum(chi, ix, N);
+                        st.rho = rho[i];
+                        st.source = addsource ? this->get_multigrid_source(level, i) : 0;
+                        st.h2_inv = h2_inv;
+
+                        T l;
+                        const T df = newton_step(chi[i], st, l);
+                        const bool active = st.rho != MARK_CHI_BOUND_COND;
+                        const bool newton = std::abs(df/(chi[i] - CHI_MIN)) < SWITCH_BIS_NEW;
+                        if (active && newton) chi[i] += df;
+                        bisect[k] = active && !newton;
+                        any_bisect = any_bisect || bisect[k];
+                    }
+
+                    if (!any_bisect) continue;
+                    for (size_t k = 0; k < num_x; ++k)
+                    {
+                        const size_t i = rw.row + x_0 + 2*k;
+                        if (bisect[k]) chi[i] = upd_point(chi[i], get_stencil(level, i, true));
+                    }
+                }
+            }
+        }
+    }
+
+    template<typename U>
+    double rms_residual(const size_t level, U const* const chi) const
+    {/* root mean square of L(phi) at given level evaluated in type of the field 'chi', L(phi) is zero at fixed points */
+        T const* const rho = this->get_external_field(level, 0); // overdensity
+        const size_t N = this->get_N(level);
+        const bool addsource = level > 0;
+        size_t const* const row_num_active = active_set[level].row_num_active.data();
+        double res = 0;
+
+        #pragma omp parallel for reduction(+:res) schedule(static)
+        for (size_t r = 0; r < N*N; ++r)
+        {
+            if (!row_num_active[r]) continue;
+            const Row rw(r, N);
+            for (size_t ix = 0; ix < N; ++ix)
+            {
+                const size_t i = rw.row + ix;
+                const Stencil_U<U> st = {rw.nb_sum(chi, ix, N), rho[i], U(addsource ? this->get_multigrid_source(level, i) : 0), U(N*N)};
+                const double l = l_point(chi[i], st);
+                res += l*l;
+            }
+        }
+        return sqrt(res/this->get_Ntot(level));
+    }
+
+    double rms_residual(const size_t level) const { return rms_residual(level, this->get_y(level)); }
+
+    double rms_residual_active() const
+    {/* root mean square of L(phi) at the finest level skipping fixed points of 'active_set' even when they are not marked
+        in overdensity, e.g. new density of a kick which may reuse the last solution; 'fix_idx' is sorted */
+        T const* const chi = this->get_y(); // solution
+        T const* const rho = this->get_external_field(0, 0); // overdensity
+        const size_t N = this->get_N();
+        const std::vector<size_t>& fix_idx = active_set[0].fix_idx;
+        size_t const* const row_num_active = active_set[0].row_num_active.data();
+        double res = 0;
+
+        #pragma omp parallel for reduction(+:res) schedule(static)
+        for (size_t r = 0; r < N*N; ++r)
+        {
+            if (!row_num_active[r]) continue;
+            const Row rw(r, N);
+            auto fix = std::lower_bound(fix_idx.begin(), fix_idx.end(), rw.row);
+            for (size_t ix = 0; ix < N; ++ix)
+            {
+                const size_t i = rw.row + ix;
+                if ((fix != fix_idx.end()) && (*fix == i))
+                {
+                    ++fix;
+                    continue;
+                }
+                const Stencil st = {rw.nb_sum(chi, ix, N), rho[i], 0, T(N*N)};
+                const double l = l_point(chi[i], st);
+                res += l*l;
+            }
+        }
+        return sqrt(res/this->get_Ntot());
+    }
+
+    /**
+     * @brief iterate sweeps until converged, same criteria as for V-cycles
+     * 
+     * @param sweeps number of sweeps between checks of convergence
+     * @param sweep one sweep over the field
+     * @param residual rms residual of the field
+     */
+    template<class Sweep, class Residual>
+    ES iterate_sweeps(const size_t sweeps, Sweep sweep, Residual residual)
+    {
+        this->_istep_vcycle = 0;
+        this->_rms_res_i = this->_rms_res = residual();
+        ES status;
+        do
+        {
+            for (size_t j = 0; j < sweeps; ++j) sweep();
+            ++this->_istep_vcycle;
+            this->_rms_res_old = this->_rms_res;
+            this->_rms_res = residual();
+            status = check_convergence();
+        } while (status == ES::ITERATE);
+        return status;
+    }
+
+    /**
+     * @brief iterate red-black sweeps at single level until converged
+     * 
+     * @param sweeps number of sweeps between checks of convergence
+     */
+    ES solve_rb(const size_t level, const size_t sweeps)
+    {
+        return iterate_sweeps(sweeps, [=](){ ngs_sweep_rb(level); }, [=](){ return rms_residual(level); });
+    }
+
+    /**
+     * @brief iterative refinement of the finest level, residual is evaluated and the field updated in double precision,
+     * corrections are solved in precision 'T' by Newton`s linear system
+     * 
+     * The field is copied to double, each step solves 'A delta = L(phi)' with \p solve_cg as in \p solve_newton
+     * and adds 'delta' to the double copy, which is rounded back at the end. Tolerance is relative to the initial
+     * residual of the preceding solve, i.e. the same as in double precision.
+     * 
+     * @return ES exit status (SUCCESS, FAILURE, SLOW, MAX_STEPS)
+     */
+    ES refine()
+    {
+        alloc_newton();
+        T* const chi = this->get_y(); // solution
+        const size_t N_tot = this->get_Ntot();
+        chi_hi.resize(N_tot);
+        chi_hi_old.resize(N_tot);
+        std::copy(chi, chi + N_tot, chi_hi.begin());
+
+        std::cout << "Refining chameleon field in double precision...\n";
+        const double res_stop = std::max(CONVERGENCE_NEWTON_RES, CONVERGENCE_NEWTON_EPS*std::numeric_limits<double>::epsilon())*this->_rms_res_i;
+        const ES status = iterate_newton(chi_hi.data(), chi_hi_old, rms_residual(0, chi_hi.data()), res_stop, "REFINE");
+
+        #pragma omp parallel for
+        for (size_t i = 0; i < N_tot; ++i) chi[i] = T(chi_hi[i]);
+        return status;
+    }
+
     /**
      * @brief check if solution already converged
      * 
@@ -523,7 +961,10 @@ public:
 
     void check_solution(size_t level, Grid<3,T>& chi) override
     {
-        for (auto fv : fix_vals[level]) chi[fv.first] = fv.second;
+        const Active_Set& as = active_set[level];
+
+        #pragma omp parallel for
+        for (size_t k = 0; k < as.fix_idx.size(); ++k) chi[as.fix_idx[k]] = as.fix_val[k];
     }
 
     void set_convergence(double eps, double err_stop, double err_stop_min, double rms_stop_min, size_t num_fail)
@@ -565,6 +1006,37 @@ public:
         {
             f[i] = chi_min(rho[i]);
         }
+
+        // no fixed points
+        for (size_t level = 0; level < this->get_Nlevel(); ++level) set_active(level, std::vector<size_t>());
+    }
+
+    void set_active(const size_t level, const std::vector<size_t>& fix_idx)
+    {/* fix the field at given points (mark them in overdensity), all other points are active */
+        Active_Set& as = active_set[level];
+        T* const rho_grid = this->get_external_field(level, 0); // overdensity
+        const size_t N = this->get_N(level);
+
+        as.fix_idx = fix_idx;
+        as.fix_val.resize(fix_idx.size());
+        T* const chi = this->get_y(level);
+
+        #pragma omp parallel for
+        for (size_t k = 0; k < fix_idx.size(); ++k)
+        {
+            const size_t i = fix_idx[k];
+            chi[i] = as.fix_val[k] = chi_min(rho_grid[i]);
+            rho_grid[i] = MARK_CHI_BOUND_COND;
+        }
+
+        // count active points in each row
+        as.row_num_active.resize(N*N);
+
+        #pragma omp parallel for
+        for (size_t r = 0; r < N*N; ++r)
+        {
+            as.row_num_active[r] = std::count_if(rho_grid + N*r, rho_grid + N*(r + 1), [](T rho){ return rho != MARK_CHI_BOUND_COND; });
+        }
     }
 
     void set_linear_sol_at_level(Mesh& rho, const FFTW_PLAN_TYPE& p_F, const FFTW_PLAN_TYPE& p_B, size_t level)
@@ -589,23 +1061,17 @@ public:
     }
 
     void set_linear_recursively(size_t level)
-    {
+    {/* linear prediction at 'level > 0' and below, level 0 is set by the caller with its own Mesh and plans */
         // we are at the bottom level
         if (level >= this->get_Nlevel()) return;
 
-        // extract parameters
-        const size_t N = this->get_N(level);
-
-        // create temporary Mesh to compute linear potential, copy density
-        Mesh rho(N);
+        // copy density to Mesh of this level
+        alloc_linear();
+        Mesh& rho = lin_rho[level - 1];
         transform_Grid_to_Mesh(rho, this->get_external_grid(level, 0));
 
-        // initialize FFTW
-        const FFTW_PLAN_TYPE p_F = FFTW_PLAN_R2C(N, N, N, rho.real(), rho.complex(), FFTW_ESTIMATE);
-        const FFTW_PLAN_TYPE p_B = FFTW_PLAN_C2R(N, N, N, rho.complex(), rho.real(), FFTW_ESTIMATE);
-
         // set linear prediction
-        set_linear_sol_at_level(rho, p_F, p_B, level);
+        set_linear_sol_at_level(rho, lin_p_F[level - 1], lin_p_B[level - 1], level);
 
         // solve linear prediction for the next level
         set_linear_recursively(level + 1);
@@ -617,10 +1083,26 @@ public:
         // solve level = 0, use already allocated space and created plans
         set_linear_sol_at_level(rho, p_F, p_B, 0);
 
-        // recursively solve at level > 0, create new grids and plans (small)
+        // recursively solve at level > 0, use Mesh and plans of the solver
         set_linear_recursively(1);
     }
 
+    void alloc_linear()
+    {/* Mesh and FFTW plans for every coarser level, created once and kept until the solver is destroyed */
+        if (!lin_rho.empty()) return;
+
+        const size_t N_level = this->get_Nlevel();
+        lin_rho.reserve(N_level - 1); ///< plans point to data of Mesh, no reallocation allowed
+        for (size_t level = 1; level < N_level; ++level)
+        {
+            const size_t N = this->get_N(level);
+            lin_rho.emplace_back(N);
+            Mesh& rho = lin_rho.back();
+            lin_p_F.push_back(FFTW_PLAN_R2C(N, N, N, rho.real(), rho.complex(), FFTW_ESTIMATE));
+            lin_p_B.push_back(FFTW_PLAN_C2R(N, N, N, rho.complex(), rho.real(), FFTW_ESTIMATE));
+        }
+    }
+
     void set_screened(size_t level = 0)
     {/* check solution for invalid values (non-linear regime), fix values in high density regions, try to improve guess in others */
         if (level >= this->get_Nlevel()) return; ///< we are at the bottom level
@@ -630,35 +1112,359 @@ public:
         const size_t N = this->get_N(level);
         T* const rho_grid = this->get_external_field(level, 0); // overdensity
         std::vector<size_t> index_list;
+        std::vector<char> fixed(N_tot, 0);
 
         #pragma omp parallel for private(index_list)
         for (size_t i = 0; i < N_tot; ++i)
         {
             if (chi[i] <= CHI_MIN) // non-linear regime
             {
-                if (check_surr_dens(rho_grid, index_list, i, N)) chi[i] = CHI_MIN; ///< CHI_MIN to indicate high-density region
+                if (check_surr_dens(rho_grid, index_list, i, N)) fixed[i] = 1; ///< high-density region
                 else chi[i] = rho_grid[i] > 0 ? chi_min(rho_grid[i]) : 1/2. + CHI_MIN;//< phi_s / 2 in underdense region as starting point
             }
         }
 
-        fix_vals[level].clear();
+        // fix chameleon to bulk value, set unphysical density to indicate screened regime
+        std::vector<size_t> fix_idx;
+        get_indices(fixed, 1, fix_idx);
+        set_active(level, fix_idx);
+
+        size_t num_high_density = fix_idx.size();
+        std::cout << "Identified and fixed " << num_high_density << "(" << std::setprecision(2) << num_high_density*100.0/N_tot <<  "%) points at level " << level << "\n";
+
+        set_screened(level + 1); ///< recursive call to fix all levels
+    }
+
+    void set_screened_warm(size_t level = 0)
+    {/* keep previous solution as a guess, keep fixed points which are still local maxima of density and fix new local maxima
+        where the previous solution is already close to the bulk value (near CHI_MIN for high density), i.e. newly screened */
+        if (level >= this->get_Nlevel()) return; ///< we are at the bottom level
+
+        const size_t N_tot = this->get_Ntot(level);
+        const size_t N = this->get_N(level);
+        T const* const rho_grid = this->get_external_field(level, 0); // overdensity
+        T const* const chi = this->get_y(level); // guess
+        const std::vector<size_t>& fix_idx_old = active_set[level].fix_idx;
+        std::vector<size_t> index_list;
+        std::vector<char> fixed(N_tot, 0), was_fixed(N_tot, 0);
+
+        // released points keep their previous (physical) value
+        #pragma omp parallel for private(index_list)
+        for (size_t k = 0; k < fix_idx_old.size(); ++k)
+        {
+            const size_t i = fix_idx_old[k];
+            was_fixed[i] = 1;
+            fixed[i] = check_surr_dens(rho_grid, index_list, i, N);
+        }
 
-        // writing into map, do not use omp
+        size_t num_new = 0;
+        #pragma omp parallel for private(index_list) reduction(+:num_new)
         for (size_t i = 0; i < N_tot; ++i)
         {
-            if (chi[i] == CHI_MIN) // fix chameleon to bulk value, set unphysical density to indicate screened regime
+            if (was_fixed[i] || !check_surr_dens(rho_grid, index_list, i, N)) continue;
+            if (chi[i] - CHI_MIN <= (1 + SWITCH_SCREENED_WARM)*(chi_min(rho_grid[i]) - CHI_MIN))
+            {
+                fixed[i] = 1;
+                ++num_new;
+            }
+        }
+
+        std::vector<size_t> fix_idx;
+        get_indices(fixed, 1, fix_idx);
+
+        size_t num_high_density = fix_idx.size();
+        std::cout << "Kept " << num_high_density - num_new << " of " << fix_idx_old.size() << " and fixed " << num_new << " new, "
+                  << num_high_density << "(" << std::setprecision(2) << num_high_density*100.0/N_tot << "%) fixed points at level " << level << "\n";
+
+        // mark screened regime only after all points were checked against their neighbours
+        set_active(level, fix_idx);
+
+        set_screened_warm(level + 1); ///< recursive call to fix all levels
+    }
+
+    /**
+     * @brief solve the equation with Newton`s method, each step solves linear system 'A delta = L(phi)' with 'A = -dL/dphi'
+     * 
+     * 'A' is positive definite (negative laplacian plus positive diagonal term) and never assembled, the system is solved
+     * with conjugate gradients preconditioned by one V-cycle of linear multigrid. Fixed points are kept constant.
+     * Relative tolerance is limited by precision of 'T'. When halving of the step does not decrease the residual,
+     * the solution from the previous step is restored.
+     * 
+     * @return ES exit status (SUCCESS, FAILURE, SLOW, MAX_STEPS)
+     */
+    ES solve_newton()
+    {
+        alloc_newton();
+        const double res_i = this->_rms_res_i = rms_residual(0);
+        const double res_stop = std::max(CONVERGENCE_NEWTON_RES, CONVERGENCE_NEWTON_EPS*std::numeric_limits<T>::epsilon())*res_i;
+        return iterate_newton(this->get_y(), chi_old, res_i, res_stop, "NEWTON");
+    }
+
+    /**
+     * @brief Newton`s steps of the finest level stored in type 'U', the Jacobian and corrections are in precision 'T'
+     * 
+     * @param chi field at the finest level, 'T' for \p solve_newton or 'double' for \p refine
+     * @param chi_prev storage of the field from the previous step
+     * @param res_i rms residual of 'chi'
+     * @param res_stop stop when rms residual is below
+     * @param name printed name of the method
+     */
+    template<typename U>
+    ES iterate_newton(U* const chi, std::vector<U>& chi_prev, const double res_i, const double res_stop, const char* const name)
+    {
+        T const* const rho = this->get_external_field(0, 0); // overdensity
+        const size_t N = this->get_N();
+        const size_t N_tot = this->get_Ntot();
+        double res = res_i;
+        size_t newton_steps = 0, cg_steps = 0;
+        ES status = ES::MAX_STEPS;
+
+        for (; newton_steps < CONVERGENCE_NEWTON_STEPS; ++newton_steps)
+        {
+            if (res <= res_stop)
+            {
+                status = ES::SUCCESS;
+                break;
+            }
+
+            /// - solve linear system for Newton`s correction
+            set_jacobian(chi);
+
+            #pragma omp parallel for
+            for (size_t i = 0; i < N_tot; ++i)
+            {
+                const Stencil_U<U> st = {nb_sum(chi, i, N), rho[i], 0, U(N*N)};
+                cg_r[i] = T(l_point(chi[i], st));
+            }
+            cg_steps += solve_cg();
+
+            /// - update solution, halve the step while residual increases
+            std::copy(chi, chi + N_tot, chi_prev.begin());
+            double res_new;
+            U lambda = 1;
+            for (size_t j = 0; ; ++j, lambda /= 2)
+            {
+                #pragma omp parallel for
+                for (size_t i = 0; i < N_tot; ++i)
+                {
+                    chi[i] = std::max<U>(chi_prev[i] + lambda*cg_delta[i], CHI_MIN + CONVERGENCE_NEWTON_MIN*(chi_prev[i] - CHI_MIN));
+                }
+                res_new = rms_residual(0, chi);
+                if ((res_new < res) || (j == CONVERGENCE_NEWTON_BACKTRACK)) break;
+            }
+
+            if (res_new >= res)
             {
+                std::copy(chi_prev.begin(), chi_prev.end(), chi);
+                status = ES::FAILURE;
+                ++newton_steps;
+                break;
+            }
 
-                chi[i] = chi_min(rho_grid[i]);
-                rho_grid[i] = MARK_CHI_BOUND_COND;
-                fix_vals[level].emplace(i, chi[i]);
+            const double err = res_new/res;
+            res = res_new;
+            if (err > CONVERGENCE_ERR)
+            {
+                status = ES::SLOW;
+                ++newton_steps;
+                break;
             }
         }
 
-        size_t num_high_density = fix_vals[level].size();
-        std::cout << "Identified and fixed " << num_high_density << "(" << std::setprecision(2) << num_high_density*100.0/N_tot <<  "%) points at level " << level << "\n";
+        std::cout << "\t" << name << ": res = " << res << ", res_i = " << res_i << " (" << newton_steps << " Newton steps, "
+                  << cg_steps << " CG iterations)\n";
+        return status;
+    }
 
-        set_screened(level + 1); ///< recursive call to fix all levels
+    void alloc_newton()
+    {
+        if (!jac_N.empty()) return;
+
+        for (size_t N = this->get_N(); ; N /= 2)
+        {
+            const size_t N_tot = N*N*N;
+            jac_N.push_back(N);
+            jac_diag.emplace_back(N_tot);
+            jac_x.emplace_back(N_tot);
+            jac_b.emplace_back(N_tot);
+            jac_r.emplace_back(N_tot);
+            if ((N % 2) || (N / 2 < 4)) break;
+        }
+
+        const size_t N_tot = this->get_Ntot();
+        jac_fixed.resize(N_tot);
+        for (std::vector<T>* vec : {&cg_delta, &cg_r, &cg_z, &cg_p, &cg_q, &chi_old}) vec->resize(N_tot);
+    }
+
+    template<typename U>
+    void set_jacobian(U const* const chi)
+    {/* diagonal term of 'A' at solution 'chi' of the finest level, averaged down to coarser levels */
+        T const* const rho = this->get_external_field(0, 0); // overdensity
+        const size_t N_tot = this->get_Ntot();
+
+        #pragma omp parallel for
+        for (size_t i = 0; i < N_tot; ++i)
+        {
+            jac_fixed[i] = rho[i] == MARK_CHI_BOUND_COND;
+            jac_diag[0][i] = T(chi_prefactor*(1-n)*std::pow(chi[i] - CHI_MIN, U(n)-2));
+        }
+
+        for (size_t level = 1; level < jac_N.size(); ++level) restrict_jacobian(jac_diag[level - 1], jac_diag[level], level);
+    }
+
+    void restrict_jacobian(const std::vector<T>& fine, std::vector<T>& coarse, const size_t level) const
+    {/* average over 8 fine points */
+        const size_t N = jac_N[level];
+        const size_t N_f = jac_N[level - 1];
+
+        #pragma omp parallel for
+        for (size_t i = 0; i < N*N*N; ++i)
+        {
+            const size_t i_f = 2*(i % N) + N_f*(2*(i / N % N) + N_f*2*(i / (N*N)));
+            coarse[i] = (fine[i_f] + fine[i_f + 1] + fine[i_f + N_f] + fine[i_f + N_f + 1]
+                      + fine[i_f + N_f*N_f] + fine[i_f + N_f*N_f + 1] + fine[i_f + N_f*N_f + N_f] + fine[i_f + N_f*N_f + N_f + 1]) / 8;
+        }
+    }
+
+    void apply_jacobian(const size_t level, const std::vector<T>& x, std::vector<T>& y) const
+    {/* y = A x, zero at fixed points of the finest level */
+        const size_t N = jac_N[level];
+        const T h2_inv = T(N*N);
+        T const* const d = jac_diag[level].data();
+
+        #pragma omp parallel for
+        for (size_t i = 0; i < N*N*N; ++i)
+        {
+            y[i] = (!level && jac_fixed[i]) ? 0 : (2*3*x[i] - nb_sum(x.data(), i, N))*h2_inv + d[i]*x[i];
+        }
+    }
+
+    void smooth_jacobian(const size_t level, const size_t colour_first)
+    {/* one red-black Gauss-Seidel sweep of 'A x = b' */
+        const size_t N = jac_N[level];
+        const T h2_inv = T(N*N);
+        T* const x = jac_x[level].data();
+        T const* const b = jac_b[level].data();
+        T const* const d = jac_diag[level].data();
+
+        for (size_t c = 0; c < 2; ++c)
+        {
+            const size_t colour = (colour_first + c) % 2;
+
+            #pragma omp parallel for collapse(2)
+            for (size_t iz = 0; iz < N; ++iz)
+            {
+                for (size_t iy = 0; iy < N; ++iy)
+                {
+                    for (size_t ix = (iy + iz + colour) % 2; ix < N; ix += 2)
+                    {
+                        const size_t i = ix + N*(iy + N*iz);
+                        if (!level && jac_fixed[i]) continue;
+                        x[i] = (b[i] + nb_sum(x, i, N)*h2_inv)/(2*3*h2_inv + d[i]);
+                    }
+                }
+            }
+        }
+    }
+
+    void vcycle_jacobian(const size_t level)
+    {/* one V-cycle of 'A x = b' starting from 'x = 0', symmetric in order of smoothing so it can precondition conjugate gradients */
+        std::vector<T>& x = jac_x[level];
+        std::fill(x.begin(), x.end(), 0);
+
+        // coarsest level
+        if (level + 1 == jac_N.size())
+        {
+            for (size_t j = 0; j < 10; ++j)
+            {
+                smooth_jacobian(level, 0);
+                smooth_jacobian(level, 1);
+            }
+            return;
+        }
+
+        // pre-smoothing, red first
+        for (size_t j = 0; j < 2; ++j) smooth_jacobian(level, 0);
+
+        // residual onto coarser level
+        std::vector<T>& r = jac_r[level];
+        apply_jacobian(level, x, r);
+
+        #pragma omp parallel for
+        for (size_t i = 0; i < r.size(); ++i) r[i] = jac_b[level][i] - r[i];
+
+        restrict_jacobian(r, jac_b[level + 1], level + 1);
+        vcycle_jacobian(level + 1);
+
+        // prolongate correction
+        const size_t N = jac_N[level];
+        const size_t N_c = jac_N[level + 1];
+        T const* const x_c = jac_x[level + 1].data();
+
+        #pragma omp parallel for
+        for (size_t i = 0; i < x.size(); ++i)
+        {
+            if (!level && jac_fixed[i]) continue;
+            x[i] += x_c[i % N / 2 + N_c*(i / N % N / 2 + N_c*(i / (N*N) / 2))];
+        }
+
+        // post-smoothing, black first
+        for (size_t j = 0; j < 2; ++j) smooth_jacobian(level, 1);
+    }
+
+    void precondition(const std::vector<T>& r, std::vector<T>& z)
+    {
+        std::copy(r.begin(), r.end(), jac_b[0].begin());
+        vcycle_jacobian(0);
+        std::copy(jac_x[0].begin(), jac_x[0].end(), z.begin());
+    }
+
+    size_t solve_cg()
+    {/* preconditioned conjugate gradients for 'A delta = L(phi)', 'L(phi)' is stored in 'cg_r', returns number of iterations */
+        std::fill(cg_delta.begin(), cg_delta.end(), 0);
+        const double r0_norm = sqrt(dot(cg_r, cg_r));
+        if (r0_norm == 0) return 0;
+
+        precondition(cg_r, cg_z);
+        cg_p = cg_z;
+        double rz = dot(cg_r, cg_z);
+        size_t k = 0;
+
+        while (k < CONVERGENCE_CG_STEPS)
+        {
+            apply_jacobian(0, cg_p, cg_q);
+            const T alpha = rz/dot(cg_p, cg_q);
+
+            #pragma omp parallel for
+            for (size_t i = 0; i < cg_delta.size(); ++i)
+            {
+                cg_delta[i] += alpha*cg_p[i];
+                cg_r[i] -= alpha*cg_q[i];
+            }
+            ++k;
+            if (sqrt(dot(cg_r, cg_r)) < CONVERGENCE_CG_RES*r0_norm) break;
+
+            precondition(cg_r, cg_z);
+            const double rz_new = dot(cg_r, cg_z);
+            const T beta = rz_new/rz;
+            rz = rz_new;
+
+            #pragma omp parallel for
+            for (size_t i = 0; i < cg_p.size(); ++i) cg_p[i] = cg_z[i] + beta*cg_p[i];
+        }
+        return k;
+    }
+
+    T get_nonlinearity(size_t level = 0) const
+    {/* maximal deviation of the field from the bulk value at mean density, '1 + CHI_MIN' */
+        T const* const chi = this->get_y(level);
+        const size_t N_tot = this->get_Ntot(level);
+        T max_dchi = 0;
+
+        #pragma omp parallel for reduction(max:max_dchi)
+        for (size_t i = 0; i < N_tot; ++i) max_dchi = std::max(max_dchi, std::abs(chi[i] - 1 - CHI_MIN));
+
+        return max_dchi;
     }
 
     T chi_min(T delta) const
@@ -669,6 +1475,19 @@ public:
     }
 
 }; // class ChiSolver end
+
+/**
+ * @brief whether the last solution of chameleon field is kept for a kick (sub-cycling)
+ * 
+ * @param res residual of the last solution for the new density (in units of density contrast), see \p ChiSolver::rms_residual_active
+ * @param resolve_res tolerance of the residual, 0 to disable
+ * @param resolve_steps solve the field at least every 'resolve_steps' kicks, 0 for no limit
+ * @param num_reused number of kicks which already reused the last solution
+ */
+bool keep_solution(const FTYPE_t res, const FTYPE_t resolve_res, const unsigned resolve_steps, const unsigned num_reused)
+{
+    return (!resolve_steps || (num_reused + 1 < resolve_steps)) && (!resolve_res || (res < resolve_res));
+}
 } ///< end of anonymous namespace (private definitions)
 
 /****************************//**
@@ -685,8 +1504,14 @@ class App_Var_Chi::ChiImpl
 public:
     // CONSTRUCTOR
     ChiImpl(const Sim_Param &sim):
-        sol(sim.box_opt.mesh_num, sim, false), drho(sim.box_opt.mesh_num), N_level_orig(sol.get_Nlevel()), x_0(sim.x_0())
+        sol(sim.box_opt.mesh_num, sim, false), drho(sim.box_opt.mesh_num), x_0(sim.x_0()), warm(sim.chi_opt.warm),
+        linear(sim.chi_opt.linear), newton(sim.chi_opt.newton), fd(sim.chi_opt.fd), fd_smooth(sim.chi_opt.fd_smooth),
+        resolve_steps(sim.chi_opt.resolve_steps), resolve_res(sim.chi_opt.resolve_res)
     {
+        if ((linear < 0) || (linear >= 1)) throw std::out_of_range("invalid value of linear threshold of chameleon field");
+        if (!resolve_steps && !resolve_res) throw std::out_of_range("chameleon field reused without limit, set 'chi_resolve_steps' or 'chi_resolve_res'");
+        if (resolve_res < 0) throw std::out_of_range("invalid value of residual tolerance of chameleon field");
+
         // EFFICIENTLY ALLOCATE VECTOR OF MESHES
         chi_force.reserve(3);
         for(size_t i = 0; i < 3; i++){
@@ -698,6 +1523,12 @@ public:
         memory_alloc += sizeof(CHI_PREC_t)*8*(sol.get_Ntot()-1)/7 // MultiGrid<3, CHI_PREC_t>
                                           *3; // _f, _res, _source
         memory_alloc += sizeof(CHI_PREC_t)*8*(sol.get_Ntot()-1)/7;// MultiGrid<3, CHI_PREC_t> drho
+        memory_alloc += (sizeof(size_t) + sizeof(char))*8*(sol.get_Ntot()-1)/7;// active sets
+        if (newton || CHI_REFINE) memory_alloc += sizeof(CHI_PREC_t)*(4*8*(sol.get_Ntot()-1)/7 // linear multigrid
+                                                                   + 6*sol.get_Ntot()) // conjugate gradients
+                                                + sizeof(char)*sol.get_Ntot(); // fixed points
+        if (CHI_REFINE) memory_alloc += sizeof(double)*2*sol.get_Ntot(); // finest level in double precision
+        memory_alloc += sizeof(FTYPE_t)*(sol.get_Ntot()-1)/7; // Mesh of linear guess at coarser levels
 
         // SET CHI SOLVER
         sol.add_external_grid(&drho);
@@ -709,9 +1540,13 @@ public:
     MultiGrid<3, CHI_PREC_t> drho;
     std::vector<Mesh> chi_force;
     uint64_t memory_alloc;
+    FTYPE_t a_sol = 0; ///< scale factor of the last solution, 0 if there is none
+    bool sol_linear = false; ///< the last solution is linear, nonlinear solver has no state to start from
+    unsigned num_reused = 0; ///< number of kicks since the last solution which reused it
 
     // METHODS
-    void solve(FTYPE_t a, const std::vector<Particle_v<FTYPE_t>>& particles, const Sim_Param &sim, const FFTW_PLAN_TYPE& p_F, const FFTW_PLAN_TYPE& p_B)
+    void solve(FTYPE_t a, const std::vector<Particle_v<FTYPE_t>>& particles, const Sim_Param &sim, const FFTW_PLAN_TYPE& p_F, const FFTW_PLAN_TYPE& p_B,
+               const bool kick = false)
     {
         /// - set prefactor
         sol.set_time(a, sim.cosmo);
@@ -724,15 +1559,34 @@ public:
         get_rho_from_par(particles, chi_force[0], sim);
         transform_Mesh_to_MultiGrid(chi_force[0], drho);
 
-        /// - set guess from linear theory and correct unphysical values
-        std::cout << "Setting linear guess for chameleon field...\n";
-        sol.set_linear(chi_force[0], p_F, p_B);
-        sol.set_screened();
+        /// - sub-cycling, keep the last solution between kicks if it still solves equations for the new density
+        if (kick && reuse()) return;
+        num_reused = 0;
 
-        /// - get multigrid_solver runnig
-        std::cout << "Solving equations of motion for chameleon field...\n";
-        solve_multigrid(); ///< solve using multigrid teqniques
-        solve_finest(); ///< solve only on the finest mesh using NGS sweeps
+        /// - start from the previous solution, or from linear theory if there is none or it failed
+        if (!warm || !a_sol || sol_linear || !solve_warm())
+        {
+            std::cout << "Setting linear guess for chameleon field...\n";
+            sol.set_linear_sol_at_level(chi_force[0], p_F, p_B, 0);
+
+            /// - weakly screened regime, linear solution is good enough
+            sol_linear = linear && solve_linear();
+            if (sol_linear)
+            {
+                a_sol = a;
+                return;
+            }
+            sol.set_linear_recursively(1);
+            sol.set_screened();
+
+            /// - get multigrid_solver runnig
+            std::cout << "Solving equations of motion for chameleon field...\n";
+            const bool multigrid = !newton || (sol.solve_newton() == ES::FAILURE); ///< solve using Newton-Krylov method
+            if (newton && multigrid) std::cout << "Newton`s method did not converge, continuing with nonlinear multigrid...\n";
+            if (multigrid) solve_multigrid(); ///< solve using multigrid teqniques
+            if (multigrid || CHI_REFINE) solve_finest(); ///< solve only on the finest mesh, refined in double precision when stored in float
+        }
+        a_sol = a;
     }
 
     void gen_pow_spec_binned(const Sim_Param &sim, Data_Vec<FTYPE_t,2>& pwr_spec_binned, const FFTW_PLAN_TYPE& p_F)
@@ -745,63 +1599,122 @@ public:
 
     void get_chi_force(const FFTW_PLAN_TYPE& p_F, const FFTW_PLAN_TYPE& p_B)
     {
+        if (fd)
+        {
+            get_force_fd(sol.get_grid(), chi_force); // - get chi force directly from solution
+            if (fd_smooth) for (size_t k = 0; k < 3; k++)
+            {// - smooth in transverse directions
+                smooth_121(chi_force[k], (k + 1) % 3);
+                smooth_121(chi_force[k], (k + 2) % 3);
+            }
+            return;
+        }
         transform_MultiGridSolver_to_Mesh(chi_force[0], sol); // - get solution
         fftw_execute_dft_r2c(p_F, chi_force[0]); // - get chi(k)
         gen_displ_k_cic(chi_force, chi_force[0]); // - get -k*chi(k)
         fftw_execute_dft_c2r_triple(p_B, chi_force);// - get chi force
     }
 
-    void kick_step_w_chi(const Cosmo_Param &cosmo, const FTYPE_t a, const FTYPE_t da, std::vector<Particle_v<FTYPE_t>>& particles, const std::vector< Mesh> &force_field)
+    void kick_step_w_chi(const Cosmo_Param &cosmo, const Integ_Coeff& coeff, std::vector<Particle_v<FTYPE_t>>& particles, const std::vector< Mesh> &force_field)
     {
         const size_t Np = particles.size();
         Vec_3D<FTYPE_t> force;
+        const FTYPE_t a = coeff.a_half;
         const FTYPE_t D = growth_factor(a, cosmo);
-        const FTYPE_t OL = cosmo.Omega_L()*pow(a,3);
-        const FTYPE_t Om = cosmo.Omega_m;
-        const FTYPE_t OLa = OL/(Om+OL);
 
-        /// - -3/2a represents usual EOM, the rest are LCDM corrections
-        const FTYPE_t f1 = 3/(2*a)*(1 + OLa);
-        const FTYPE_t f2 = 3/(2*a)*(1 - OLa)*D/a;
         /// - chameleon force factor + units
         const FTYPE_t f3 = a/D*sol.chi_force_units(a)/pow2(x_0);
 
-        // force.fill(0.);
-        // assign_from(force_field, particles[0].position, force);
-        // std::cout << "\n=======> Gr = " << force.norm() << "\tGr_x = " << force[0];
-        // force.fill(0.);
-        // assign_from(chi_force, particles[0].position, force, f3);
-        // std::cout << "\tChi = " << force.norm() << "\tChi_x = " << force[0] << "\n";        
-        
+        /// - total force on the mesh, one interpolation per particle
+        for (size_t k = 0; k < 3; k++)
+        {
+            if (force_field[k].length != chi_force[k].length) throw std::range_error("Force meshes of different sizes!");
+            FTYPE_t* const chi_k = chi_force[k].real();
+            FTYPE_t const* const grav_k = force_field[k].real();
+
+            #pragma omp parallel for simd
+            for (size_t i = 0; i < chi_force[k].length; i++) chi_k[i] = grav_k[i] + f3*chi_k[i];
+        }
+
         #pragma omp parallel for private(force)
         for (size_t i = 0; i < Np; i++)
         {
             force.fill(0.);
-            assign_from(force_field, particles[i].position, force);
-            assign_from(chi_force, particles[i].position, force, f3);
-            force = force*f2 - particles[i].velocity*f1;		
-            particles[i].velocity += force*da;
+            assign_from(chi_force, particles[i].position, force);
+            particles[i].velocity = particles[i].velocity*coeff.kick_v + force*coeff.kick_F;
         }
     }
 
+    bool reuse()
+    {/* the field is in 'chi_a' units so rescaling of the last solution by 'chi_a(a)/chi_a(a_sol)' keeps the stored values; residual
+        of the new density at active points of the last solution (re-deposited density is not marked) is divided by the prefactor
+        of the source term, i.e. it is an error of density contrast comparable to the residual of the solver;
+        'resolve_steps == 0' puts no limit on the number of reused kicks, only the residual decides */
+        if ((resolve_steps == 1) || !a_sol || sol_linear) return false;
+
+        const FTYPE_t res = sol.rms_residual_active() / sol.get_chi_prefactor();
+        const bool use_old = keep_solution(res, resolve_res, resolve_steps, num_reused);
+        std::cout << "Residual of chameleon field from a = " << a_sol << ": " << res;
+        if (resolve_res) std::cout << " (tolerance = " << resolve_res << ")";
+        if (use_old)
+        {
+            ++num_reused;
+            std::cout << ", reusing the solution (" << num_reused;
+            if (resolve_steps) std::cout << "/" << resolve_steps - 1;
+            std::cout << ")\n";
+        }
+        else std::cout << ", solving again\n";
+        return use_old;
+    }
+
 private:
-    const size_t N_level_orig;
     const FTYPE_t x_0;
-
-    void solve_multigrid()
+    const bool warm;
+    const FTYPE_t linear;
+    const bool newton;
+    const bool fd, fd_smooth;
+    const unsigned resolve_steps;
+    const FTYPE_t resolve_res;
+
+    ES solve_multigrid()
     {
         sol.set_ngs_sweeps(3, 6); ///< fine, coarse
         sol.set_maxsteps(30);
-        ES status = sol.solve();
+        return sol.solve();
     }
 
-    void solve_finest()
+    ES solve_finest()
     {
-        sol.set_ngs_sweeps(5, 0); ///< fine, coarse
-        sol.set_Nlevel(1);
+        if (CHI_REFINE) return sol.refine();
         sol.set_maxsteps(30);
-        ES status = sol.solve();
-        sol.set_Nlevel(N_level_orig);
+        return sol.solve_rb(0, 5);
+    }
+
+    bool solve_linear()
+    {/* nonlinear terms neglected by the linear solution are of relative order '(2-n)/2*|dchi|' */
+        const FTYPE_t nonlinearity = sol.get_nonlinearity();
+        const bool use_linear = nonlinearity < linear;
+        std::cout << "Nonlinearity of chameleon field: max|dchi| = " << nonlinearity << " (threshold = " << linear << "), "
+                  << (use_linear ? "using linear solution\n" : "solving nonlinear equations\n");
+        return use_linear;
+    }
+
+    bool solve_warm()
+    {/* use solution from 'a_sol' as the initial guess at all levels, the field is in 'chi_a' units (its bulk value does not depend
+        on time) so rescaling by 'chi_a(a)/chi_a(a_sol)' keeps the stored values; density in 'chi_force[0]' is kept for a fallback */
+        std::cout << "Setting warm guess for chameleon field from a = " << a_sol << "...\n";
+        sol.set_screened_warm();
+
+        std::cout << "Solving equations of motion for chameleon field...\n";
+        const ES status = newton ? sol.solve_newton() : solve_multigrid();
+        if ((status == ES::FAILURE) || (status == ES::MAX_STEPS))
+        {
+            std::cout << "Warm start did not converge, starting again from linear guess...\n";
+            transform_Mesh_to_MultiGrid(chi_force[0], drho); ///< remove marks of screened regime
+            return false;
+        }
+        if (!newton || CHI_REFINE) solve_finest();
+        return true;
     }
 };
 
@@ -828,13 +1741,12 @@ void App_Var_Chi::print_output()
 }
 
 void App_Var_Chi::upd_pos()
-{// Leapfrog method for chameleon gravity (frozen-potential)
-    auto kick_step = [&]()
+{// Symplectic integrator for chameleon gravity (frozen-potential)
+    auto kick_step = [&](const Integ_Coeff& coeff)
     {
-        m_impl->solve(a_half(), particles, sim, p_F, p_B);
+        m_impl->solve(coeff.a_half, particles, sim, p_F, p_B, true);
         m_impl->get_chi_force(p_F, p_B);
-        //kick_step_w_momentum(sim.cosmo, a_half(), da(), particles, app_field);
-        m_impl->kick_step_w_chi(sim.cosmo, a_half(), da(), particles, app_field);
+        m_impl->kick_step_w_chi(sim.cosmo, coeff, particles, app_field);
     };
-    stream_kick_stream(da(), particles, kick_step, sim.box_opt.mesh_num);
+    symplectic_step(sim, a(), da(), particles, kick_step, sim.box_opt.mesh_num);
 }
\ No newline at end of file
@@ -0,0 +1,145 @@
+/**
+ * @brief COmoving Lagrangian Acceleration (COLA) method implementation
+ * 
+ * @file cola.cpp
+ */
+
+#include "cola.hpp"
+#include "core_app.h"
+#include "core_mesh.h"
+#include "core_power.h"
+#include "integration.hpp"
+#include "params.hpp"
+
+/*****************************//**
+ * PRIVATE FUNCTIONS DEFINITIONS *
+ *********************************/
+namespace {
+
+/**
+ * @brief growth factors of LPT trajectories at given time
+ */
+struct LPT_Growth
+{
+    LPT_Growth(const FTYPE_t a, const Cosmo_Param& cosmo):
+        D(growth_factor(a, cosmo)), dDda(growth_change(a, cosmo)),
+        D_2(growth_factor_2(a, cosmo)), dD2da(growth_change_2(a, cosmo)) {}
+    FTYPE_t D, dDda, D_2, dD2da;
+};
+
+/**
+ * @brief stream in frame comoving with LPT trajectories
+ * 
+ * @param stream stream factor for residual velocity \f$ v - \frac{dD}{da}\Psi^{(1)} - \frac{dD_2}{da}\Psi^{(2)} \f$
+ * @param g_s growth at the start of the stream
+ * @param g_e growth at the end of the stream
+ * @param g_v growth at the time when velocities are defined
+ * @param particles particles to move
+ * @param displ first-order Lagrangian displacement of particles
+ * @param displ_2 second-order Lagrangian displacement of particles, empty for first-order frame
+ */
+void stream_step_cola(const FTYPE_t stream, const LPT_Growth& g_s, const LPT_Growth& g_e, const LPT_Growth& g_v,
+                      std::vector<Particle_v<FTYPE_t>>& particles, const std::vector<Vec_3D<FTYPE_t>>& displ,
+                      const std::vector<Vec_3D<FTYPE_t>>& displ_2)
+{
+    const size_t Np = particles.size();
+    const bool lpt2 = !displ_2.empty();
+    #pragma omp parallel for
+	for (size_t i = 0; i < Np; i++)
+	{
+        particles[i].position += (particles[i].velocity - displ[i]*g_v.dDda)*stream + displ[i]*(g_e.D - g_s.D);
+        if (lpt2) particles[i].position += displ_2[i]*(g_e.D_2 - g_s.D_2 - g_v.dD2da*stream);
+    }
+}
+
+/**
+ * @brief kick residual velocity by residual force, LPT part of velocity is known analytically
+ * 
+ * @param coeff integration coefficients of the time-step
+ * @param g_0 growth at the beginning of the time-step
+ * @param g_half growth at the time of the kick
+ * @param g_1 growth at the end of the time-step
+ * @param particles particles to kick
+ * @param force_field force in units of frozen potential force
+ * @param displ first-order Lagrangian displacement of particles
+ * @param displ_2 second-order Lagrangian displacement of particles, empty for first-order frame
+ * 
+ * In units of frozen potential force the LPT force is \f$ \Psi^{(1)} + \frac{D_2 - D^2}{D}\Psi^{(2)} \f$.
+ */
+void kick_step_cola(const Integ_Coeff& coeff, const LPT_Growth& g_0, const LPT_Growth& g_half, const LPT_Growth& g_1,
+                    std::vector<Particle_v<FTYPE_t>>& particles, const std::vector< Mesh> &force_field,
+                    const std::vector<Vec_3D<FTYPE_t>>& displ, const std::vector<Vec_3D<FTYPE_t>>& displ_2)
+{
+    const size_t Np = particles.size();
+    const bool lpt2 = !displ_2.empty();
+    const FTYPE_t F_2 = (g_half.D_2 - pow2(g_half.D))/g_half.D;
+    Vec_3D<FTYPE_t> force;
+
+    #pragma omp parallel for private(force)
+    for (size_t i = 0; i < Np; i++)
+	{
+        force.fill(0.);
+        assign_from(force_field, particles[i].position, force);
+        particles[i].velocity = (particles[i].velocity - displ[i]*g_0.dDda)*coeff.kick_v + (force - displ[i])*coeff.kick_F + displ[i]*g_1.dDda;
+        if (lpt2) particles[i].velocity += displ_2[i]*(g_1.dD2da - g_0.dD2da*coeff.kick_v - F_2*coeff.kick_F);
+    }
+}
+} ///< end of anonymous namespace (private definitions)
+
+/****************************//**
+ * PUBLIC FUNCTIONS DEFINITIONS *
+ ********************************/
+
+class App_Var_COLA::COLAImpl
+{
+public:
+    COLAImpl(const Sim_Param &sim): displ(sim.box_opt.par_num)
+    {
+        if (sim.integ_opt.ic_2lpt) displ_2.resize(sim.box_opt.par_num);
+        memory_alloc = sizeof(Vec_3D<FTYPE_t>)*(displ.size() + displ_2.size());
+    }
+
+    void cola_step(App_Var_COLA& APP)
+    {
+        const Cosmo_Param& cosmo = APP.sim.cosmo;
+        const size_t per = APP.sim.box_opt.mesh_num;
+        const Integ_Coeff coeff(APP.sim, APP.a(), APP.da());
+        const LPT_Growth g_0(APP.a() - APP.da(), cosmo);
+        const LPT_Growth g_half(coeff.a_half, cosmo);
+        const LPT_Growth g_1(APP.a(), cosmo);
+
+        stream_step_cola(coeff.stream_1, g_0, g_half, g_0, APP.particles, displ, displ_2);
+        get_per(APP.particles, per);
+
+        get_force_from_par(APP.particles, APP.app_field, APP.sim, g_half.D, APP.p_F, APP.p_B);
+        kick_step_cola(coeff, g_0, g_half, g_1, APP.particles, APP.app_field, displ, displ_2);
+
+        stream_step_cola(coeff.stream_2, g_half, g_1, g_1, APP.particles, displ, displ_2);
+        get_per(APP.particles, per);
+    }
+
+	// VARIABLES
+	std::vector<Vec_3D<FTYPE_t>> displ; ///< Lagrangian displacement of particles at \f$ D = 1 \f$
+	std::vector<Vec_3D<FTYPE_t>> displ_2; ///< second-order Lagrangian displacement (only with 2LPT initial conditions)
+    uint64_t memory_alloc;
+};
+
+App_Var_COLA::App_Var_COLA(const Sim_Param &sim):
+    App_Var<Particle_v<FTYPE_t>>(sim, "COLA", "COmoving Lagrangian Acceleration"), m_impl(new COLAImpl(sim))
+{
+    memory_alloc += m_impl->memory_alloc;
+}
+
+App_Var_COLA::~App_Var_COLA() = default;
+
+void App_Var_COLA::pot_corr()
+{
+    /* Displacement fields in q-space are still stored in app_field (and app_field_2) */
+    get_lagr_displ(sim, m_impl->displ, app_field);
+    if (!app_field_2.empty()) get_lagr_displ(sim, m_impl->displ_2, app_field_2);
+}
+
+void App_Var_COLA::upd_pos()
+{// Leapfrog method in frame comoving with LPT trajectories
+    m_impl->cola_step(*this);
+}
@@ -16,7 +16,11 @@ App_Var_FF::App_Var_FF(const Sim_Param &sim):
     App_Var<Particle_v<FTYPE_t>>(sim, "FF", "Frozen-flow approximation") {}
 
 void App_Var_FF::upd_pos()
-{// Leapfrog method for frozen-flow
-    auto kick_step = [&](){ kick_step_no_momentum(sim.cosmo, a_half(), particles, app_field); };
-    stream_kick_stream(da(), particles, kick_step, sim.box_opt.mesh_num);
+{// Leapfrog or Runge-Kutta method for frozen-flow
+    if (sim.integ_opt.order == 4) runge_kutta_no_momentum(sim.cosmo, a(), da(), particles, app_field, sim.box_opt.mesh_num);
+    else
+    {
+        const Kick_No_Momentum kick(growth_change(a_half(), sim.cosmo), app_field);
+        stream_kick_stream_fused(da()/2, da()/2, particles, kick, sim.box_opt.mesh_num);
+    }
 }
\ No newline at end of file
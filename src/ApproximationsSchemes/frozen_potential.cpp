@@ -16,7 +16,7 @@ App_Var_FP::App_Var_FP(const Sim_Param &sim):
     App_Var<Particle_v<FTYPE_t>>(sim, "FP", "Frozen-potential approximation") {}
 
 void App_Var_FP::upd_pos()
-{// Leapfrog method for frozen-potential
-    auto kick_step = [&](){ kick_step_w_momentum(sim.cosmo, a_half(), da(), particles, app_field); };
-    stream_kick_stream(da(), particles, kick_step, sim.box_opt.mesh_num);
+{// Symplectic integrator for frozen-potential
+    const Frozen_Force_Kick kick_step(app_field);
+    symplectic_step(sim, a(), da(), particles, kick_step, sim.box_opt.mesh_num);
 }
\ No newline at end of file
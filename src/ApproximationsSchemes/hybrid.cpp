@@ -0,0 +1,67 @@
+/**
+ * @brief hybrid simulations implementation
+ * 
+ * @file hybrid.cpp
+ */
+
+#include "hybrid.hpp"
+#include "params.hpp"
+#include "adhesion.hpp"
+#include "chameleon.hpp"
+#include "cola.hpp"
+#include "frozen_flow.hpp"
+#include "frozen_potential.hpp"
+#include "mod_frozen_potential.hpp"
+#include "particle_mesh.hpp"
+#include "second_order_lpt.hpp"
+#include "zeldovich.hpp"
+
+/*****************************//**
+ * PRIVATE FUNCTIONS DEFINITIONS *
+ *********************************/
+namespace {
+
+typedef std::vector<Particle_v<FTYPE_t>> Handover;
+
+template<class T>
+FTYPE_t run_stage(const Sim_Param& sim, Handover& handover, const FTYPE_t a_begin, const FTYPE_t a_end, const FTYPE_t shell_cross)
+{
+    T APP(sim);
+    return APP.run_simulation(handover, a_begin, a_end, shell_cross);
+}
+
+FTYPE_t run_stage(const std::string& app, const Sim_Param& sim, Handover& handover, const FTYPE_t a_begin, const FTYPE_t a_end,
+                  const FTYPE_t shell_cross)
+{
+    if (app == "ZA") return run_stage<App_Var_ZA>(sim, handover, a_begin, a_end, shell_cross);
+    if (app == "LPT2") return run_stage<App_Var_LPT2>(sim, handover, a_begin, a_end, shell_cross);
+    if (app == "FF") return run_stage<App_Var_FF>(sim, handover, a_begin, a_end, shell_cross);
+    if (app == "FP") return run_stage<App_Var_FP>(sim, handover, a_begin, a_end, shell_cross);
+    if (app == "AA") return run_stage<App_Var_AA>(sim, handover, a_begin, a_end, shell_cross);
+    if (app == "FP_pp") return run_stage<App_Var_FP_mod>(sim, handover, a_begin, a_end, shell_cross);
+    if (app == "COLA") return run_stage<App_Var_COLA>(sim, handover, a_begin, a_end, shell_cross);
+    if (app == "PM") return run_stage<App_Var_PM>(sim, handover, a_begin, a_end, shell_cross);
+    if (app == "chi") return run_stage<App_Var_Chi>(sim, handover, a_begin, a_end, shell_cross);
+    throw std::runtime_error("Unknown approximation '" + app + "' in hybrid simulation!");
+}
+} ///< end of anonymous namespace (private definitions)
+
+/****************************//**
+ * PUBLIC FUNCTIONS DEFINITIONS *
+ ********************************/
+
+void run_hybrid(const Sim_Param& sim)
+{
+    const Hybrid_Opt& hybrid_opt = sim.hybrid_opt;
+    const size_t num_stages = hybrid_opt.apps.size();
+    Handover handover;
+    FTYPE_t a = sim.integ_opt.b_in;
+
+    for (size_t i = 0; i < num_stages; i++)
+    {
+        const bool last = (i + 1 == num_stages);
+        const FTYPE_t a_end = last ? sim.integ_opt.b_out : 1/(hybrid_opt.z_switch[i] + 1);
+        const FTYPE_t shell_cross = last ? 0 : hybrid_opt.shell_cross;
+        a = run_stage(hybrid_opt.apps[i], sim, handover, a, std::max(a_end, a), shell_cross);
+    }
+}
@@ -47,6 +47,6 @@ private:
     // initialize potentials for adhesion
     void pot_corr() override;
 
-    // Leapfrog method for adhesion
+    // Symplectic integrator for adhesion
     void upd_pos() override;
 };
\ No newline at end of file
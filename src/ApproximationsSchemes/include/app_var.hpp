@@ -41,11 +41,14 @@ class App_Var
 {
 public:
 	// CONSTRUCTORS & DESTRUCTOR
-    App_Var(const Sim_Param &sim, const std::string& app_short, const std::string& app_long);
+    App_Var(const Sim_Param &sim, const std::string& app_short, const std::string& app_long, const bool is_2lpt = false);
 	~App_Var();
 
     // RUN THE SIMULATION
     void run_simulation();
+
+    // RUN ONE STAGE OF HYBRID SIMULATION
+    FTYPE_t run_simulation(std::vector<T>& handover, const FTYPE_t a_begin, const FTYPE_t a_end, const FTYPE_t shell_cross);
 	
 protected:
     // VARIABLES
@@ -54,6 +57,7 @@ protected:
     
     // LARGE FIELDS
 	std::vector<Mesh> app_field;
+    std::vector<Mesh> app_field_2; // second-order displacement field, empty without 2LPT
     std::vector<Mesh> power_aux;
     std::vector<T> particles;
 
@@ -73,6 +77,7 @@ protected:
     virtual void print_output(); //< save info about simulation state
 private:
     virtual void pot_corr(); //< CIC correction by default
+    virtual bool is_analytic() const; //< positions depend only on time, evaluate at output times only
     virtual void upd_pos() = 0;
 
     // IMPLEMENTATION
@@ -43,7 +43,7 @@ private:
     class ChiImpl;
     const std::unique_ptr<ChiImpl> m_impl;
 
-    // Leapfrog method for chameleon gravity (frozen-potential)
+    // Symplectic integrator for chameleon gravity (frozen-potential)
     void upd_pos() override;
 
     // Print additional information about chameleon field
@@ -0,0 +1,51 @@
+/**
+ * @brief COmoving Lagrangian Acceleration (COLA) method interface
+ * 
+ * @file cola.hpp
+ */
+
+#pragma once
+
+#include "stdafx.h"
+#include "app_var.hpp"
+#include "precision.hpp"
+#include "class_particles.hpp"
+
+/********************//**
+ * FORWARD DECLARATIONS *
+ ************************/
+
+class Sim_Param;
+
+/**************//**
+ * PUBLIC METHODS *
+ ******************/
+
+/**************//**
+ * PUBLIC CLASSES *
+ ******************/
+
+/**
+ * @class:	App_Var_COLA
+ * @brief:	class containing variables and methods for COLA method, i.e. particle-mesh
+ *          integration in a frame comoving with Lagrangian perturbation theory trajectories
+ * @ingroup APP
+ */
+class App_Var_COLA: public App_Var<Particle_v<FTYPE_t>>
+{
+public:
+	// CONSTRUCTORS & DESTRUCTOR
+	App_Var_COLA(const Sim_Param &sim);
+    ~App_Var_COLA();
+
+private:
+    // IMPLEMENTATION
+    class COLAImpl;
+    const std::unique_ptr<COLAImpl> m_impl;
+
+    // store Lagrangian displacement of particles
+    void pot_corr() override;
+
+    // Leapfrog method in frame comoving with LPT trajectories
+    void upd_pos() override;
+};
@@ -39,6 +39,6 @@ public:
 	App_Var_FF(const Sim_Param &sim);
 
 private:
-    // Leapfrog method for frozen-flow
+    // Leapfrog or Runge-Kutta method for frozen-flow
     void upd_pos() override;
 };
\ No newline at end of file
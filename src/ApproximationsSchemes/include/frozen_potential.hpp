@@ -39,6 +39,6 @@ public:
 	App_Var_FP(const Sim_Param &sim);
 
 private:
-    // Leapfrog method for frozen-potential
+    // Symplectic integrator for frozen-potential
     void upd_pos() override;
 };
\ No newline at end of file
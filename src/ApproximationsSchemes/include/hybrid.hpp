@@ -0,0 +1,29 @@
+/**
+ * @brief hybrid simulations interface, i.e. chain of approximations with handover of particles
+ * 
+ * @file hybrid.hpp
+ */
+
+#pragma once
+
+#include "stdafx.h"
+
+/********************//**
+ * FORWARD DECLARATIONS *
+ ************************/
+
+class Sim_Param;
+
+/**************//**
+ * PUBLIC METHODS *
+ ******************/
+
+/**
+ * @brief run approximations given in 'Hybrid_Opt::apps' one after another
+ * 
+ * @param sim simulation parameters
+ * 
+ * Particles and velocities at the end of one approximation are initial conditions of the next one.
+ * Handover happens at given redshifts or sooner when fraction of shell-crossed particles exceeds given value.
+ */
+void run_hybrid(const Sim_Param& sim);
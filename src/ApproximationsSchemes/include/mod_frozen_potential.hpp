@@ -46,6 +46,6 @@ private:
     // force interpolation corrections, long range potential for S2-shaped particles
     void pot_corr() override;
 
-    // Leapfrog method for modified frozen-potential
+    // Symplectic integrator for modified frozen-potential
     void upd_pos() override;
 };
\ No newline at end of file
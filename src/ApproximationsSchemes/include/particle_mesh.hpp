@@ -0,0 +1,45 @@
+/**
+ * @brief particle-mesh N-body simulation interface
+ * 
+ * @file particle_mesh.hpp
+ */
+
+#pragma once
+
+#include "stdafx.h"
+#include "app_var.hpp"
+#include "precision.hpp"
+#include "class_particles.hpp"
+
+/********************//**
+ * FORWARD DECLARATIONS *
+ ************************/
+
+class Sim_Param;
+
+/**************//**
+ * PUBLIC METHODS *
+ ******************/
+
+/**************//**
+ * PUBLIC CLASSES *
+ ******************/
+
+/**
+ * @class:	App_Var_PM
+ * @brief:	class containing variables and methods for particle-mesh N-body simulation
+ * @ingroup APP
+ */
+class App_Var_PM: public App_Var<Particle_v<FTYPE_t>>
+{
+public:
+	// CONSTRUCTORS & DESTRUCTOR
+	App_Var_PM(const Sim_Param &sim);
+
+private:
+    // no correction of initial potential, force is computed from particles
+    void pot_corr() override;
+
+    // Symplectic integrator with force recomputed every step
+    void upd_pos() override;
+};
\ No newline at end of file
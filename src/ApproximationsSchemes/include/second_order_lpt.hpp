@@ -0,0 +1,48 @@
+/**
+ * @brief second-order Lagrangian perturbation theory interface
+ * 
+ * @file second_order_lpt.hpp
+ */
+
+#pragma once
+
+#include "stdafx.h"
+#include "app_var.hpp"
+#include "precision.hpp"
+#include "class_particles.hpp"
+
+/********************//**
+ * FORWARD DECLARATIONS *
+ ************************/
+
+class Sim_Param;
+
+/**************//**
+ * PUBLIC METHODS *
+ ******************/
+
+/**************//**
+ * PUBLIC CLASSES *
+ ******************/
+
+/**
+ * @class:	App_Var_LPT2
+ * @brief:	class containing variables and methods for second-order Lagrangian perturbation theory
+ * @ingroup APP
+ */
+class App_Var_LPT2: public App_Var<Particle_v<FTYPE_t>>
+{
+public:
+	// CONSTRUCTORS & DESTRUCTOR
+	App_Var_LPT2(const Sim_Param &sim);
+
+private:
+    // no CIC correction for 2LPT
+    void pot_corr() override;
+
+    // 2LPT is evaluated at output times only
+    bool is_analytic() const override;
+
+    // 2LPT with velocitites
+    void upd_pos() override;
+};
\ No newline at end of file
@@ -42,6 +42,9 @@ private:
     // no CIC correction for ZA
     void pot_corr() override;
 
+    // ZA is evaluated at output times only
+    bool is_analytic() const override;
+
     // ZA with velocitites
     void upd_pos() override;
 };
\ No newline at end of file
@@ -10,111 +10,962 @@
 #include "core_mesh.h"
 #include "integration.hpp"
 #include "params.hpp"
+#include <algorithm>
+#include <omp.h>
 
 namespace {
 
+FTYPE_t force_ref(const FTYPE_t r, const FTYPE_t a){
+	// Reference force for an S_2-shaped particle
+	FTYPE_t z = 2 * r / a;
+	if (z > 2) return 1 / (r*r);
+	else if (z > 1) return (12 / (z*z) - 224 + 896 * z - 840 * z*z + 224 * pow(z, 3) +
+							70 * pow(z, 4) - 48 * pow(z, 5) + 7 * pow(z, 6)) / (35 * a*a);
+	else return (224 * z - 224 * pow(z, 3) + 70 * pow(z, 4) + 48 * pow(z, 5) - 21 * pow(z, 7)) / (35 * a*a);
+}
+
+FTYPE_t force_tot(const FTYPE_t r, const FTYPE_t e2){
+	return 1 / (r*r+e2);
+}
+
+void counting_sort(const std::vector<size_t>& par_bucket, const size_t row_len, std::vector<size_t>& bucket_start,
+                   std::vector<size_t>& par_idx)
+{   // parallel counting sort of particles by their buckets, 'bucket_start' has one extra element at the end,
+    // number of buckets has to be a multiple of 'row_len', order of particles within buckets is not defined
+    const size_t par_num = par_bucket.size();
+    const size_t num_rows = (bucket_start.size() - 1) / row_len;
+    std::fill(bucket_start.begin(), bucket_start.end(), 0);
+
+    // count particles in each bucket
+    #pragma omp parallel for
+    for (size_t i = 0; i < par_num; i++)
+    {
+        #pragma omp atomic
+        bucket_start[par_bucket[i] + 1]++;
+    }
+
+    // exclusive scan, first within rows of buckets, then over rows
+    std::vector<size_t> row_sum(num_rows + 1, 0);
+    #pragma omp parallel for
+    for (size_t r = 0; r < num_rows; r++)
+    {
+        for (size_t b = r*row_len + 1; b < (r + 1)*row_len; b++) bucket_start[b + 1] += bucket_start[b];
+        row_sum[r + 1] = bucket_start[(r + 1)*row_len];
+    }
+    for (size_t r = 0; r < num_rows; r++) row_sum[r + 1] += row_sum[r];
+
+    #pragma omp parallel for
+    for (size_t r = 0; r < num_rows; r++)
+    {
+        for (size_t b = r*row_len + 1; b <= (r + 1)*row_len; b++) bucket_start[b] += row_sum[r];
+    }
+
+    // scatter particles into their buckets
+    std::vector<size_t> bucket_fill(bucket_start.begin(), bucket_start.end() - 1);
+    #pragma omp parallel for
+    for (size_t i = 0; i < par_num; i++)
+    {
+        size_t j;
+        #pragma omp atomic capture
+        j = bucket_fill[par_bucket[i]]++;
+        par_idx[j] = i;
+    }
+}
+
+void print_thread_time(std::vector<double>& thread_time)
+{   // report load balance of short range force and reset timers
+    const size_t nt = thread_time.size();
+    double t_min = thread_time[0], t_max = thread_time[0], t_mean = 0;
+    for (double t : thread_time)
+    {
+        t_min = std::min(t_min, t);
+        t_max = std::max(t_max, t);
+        t_mean += t / nt;
+    }
+    printf("Short range force on %lu threads: time min = %.3fs, mean = %.3fs, max = %.3fs (imbalance %.2f)\n",
+           nt, t_min, t_mean, t_max, (t_mean > 0) ? t_max / t_mean : 1);
+    std::fill(thread_time.begin(), thread_time.end(), 0);
+}
+
 /**
- * @class LinkedList
- * @brief class handling linked lists
+ * @class Force_Table
+ * @brief uniform table of short range force (force_tot - force_ref)/(4*PI) in 'r', linear interpolation
  */
 
-class LinkedList
+class Force_Table
 {
 public:
 	// CONSTRUCTORS & DESTRUCTOR
-	LinkedList(size_t par_num, size_t m, FTYPE_t hc):
-	    par_num(par_num), Hc(hc), LL(par_num), HOC(m, m, m) {}
+    Force_Table(const FTYPE_t rs, const FTYPE_t a, const FTYPE_t e2):
+        rs2(rs*rs), dr_inv(256), max_i(int(rs*dr_inv) + 1), data(max_i + 2)
+    {
+        #pragma omp parallel for
+        for(int i = 0; i < max_i + 2; i++)
+        {
+            const FTYPE_t r = i/dr_inv;
+            data[i] = (force_tot(r, e2) - force_ref(r, a))/(4*PI);
+        }
+    }
+
+	// VARIABLES
+    FTYPE_t rs2, dr_inv; ///< square of cutoff radius, resolution of table (1/256 of mesh cell)
+    int max_i;
+    std::vector<FTYPE_t> data;
+
+	// METHODS
+    /// short range force divided by 'r', zero outside of (0, rs), no branches so it can be used in SIMD loops
+    FTYPE_t eval(const FTYPE_t r2) const
+    {
+        const FTYPE_t r = sqrt(r2);
+        const FTYPE_t x = r*dr_inv;
+        const int i = std::min(int(x), max_i);
+        const FTYPE_t f = data[i] + (x - i)*(data[i+1] - data[i]);
+        return ((r2 < rs2) && (r2 > 0)) ? f/r : 0;
+    }
+};
+
+/**
+ * @class Chaining_Mesh
+ * @brief class handling chaining mesh, particles are sorted by their chaining cell
+ * 
+ * Particles in cell 'c' are 'par_idx[cell_start[c]]' ... 'par_idx[cell_start[c+1]-1]',
+ * their positions and short range forces are packed in the same order in 'par_pos' and 'par_force'.
+ * Particles within one cell are kept in ascending order of their index so the result does not
+ * depend on thread scheduling. Cells are divided into colors, cells of the same color do not share
+ * any neighbouring cell and can be processed concurrently. Cells of one color are distributed
+ * dynamically among threads, the most expensive cells (number of pair interactions) go first.
+ * 
+ * With non-zero 'skin' each particle stores its Verlet list of neighbours closer than 'rs + skin'
+ * (from its own cell and half of the neighbouring cells). Lists and the order of particles are kept
+ * until some particle moves more than half of the skin, packed positions are only updated meanwhile.
+ */
+
+class Chaining_Mesh
+{
+public:
+	// CONSTRUCTORS & DESTRUCTOR
+	Chaining_Mesh(size_t par_num, size_t m, FTYPE_t hc, size_t per, FTYPE_t rs, FTYPE_t skin):
+	    par_num(par_num), M(m), per(per), Hc(hc), rs(rs), skin(skin), use_verlet((skin > 0) && (m >= 3)),
+        cell_start(m*m*m+1), par_cell(par_num), par_idx(par_num), cell_cost(m*m*m), thread_time(omp_get_max_threads(), 0)
+    {
+        for (size_t k = 0; k < 3; k++)
+        {
+            par_pos[k].resize(par_num);
+            par_force[k].resize(par_num);
+            if (use_verlet) par_pos_0[k].resize(par_num);
+
+            // shifts of periodic images, see 'get_shift_code'
+            for (size_t s = 0; s < 27; s++) shift_table[k][s] = FTYPE_t(per)*(int((s / (k == 0 ? 9 : (k == 1 ? 3 : 1))) % 3) - 1);
+        }
+
+        // colors along one axis repeat with period 3, cells left over by 'M % 3' get their own colors
+        const size_t M_3 = 3*(M/3);
+        auto get_color = [&](size_t i){ return (i < M_3) ? i % 3 : 3 + i - M_3; };
+        std::vector<std::vector<size_t>> colors(125);
+        for (size_t i = 0; i < M; i++){
+        for (size_t j = 0; j < M; j++){
+        for (size_t k = 0; k < M; k++){
+            colors[(get_color(i)*5 + get_color(j))*5 + get_color(k)].push_back(get_cell(i, j, k));
+        }}}
+        for (auto& color : colors) if (!color.empty()) color_cells.push_back(std::move(color));
+    }
 	
 	// VARIABLES
-	size_t par_num;
-	FTYPE_t Hc;
-	std::vector<size_t> LL;
-	Mesh_base<size_t> HOC;
+	size_t par_num, M, per;
+	FTYPE_t Hc, rs, skin;
+    bool use_verlet; ///< Verlet lists are used only when every particle has at most one image in them
+	std::vector<size_t> cell_start; ///< offsets of cells into 'par_idx', one extra element at the end
+	std::vector<size_t> par_cell; ///< chaining cell of each particle
+	std::vector<size_t> par_idx; ///< particle indices sorted by chaining cell
+	std::vector<FTYPE_t> par_pos[3]; ///< particle positions sorted by chaining cell
+	std::vector<FTYPE_t> par_force[3]; ///< short range force sorted by chaining cell
+    std::vector<std::vector<size_t>> color_cells; ///< cells divided into independent sets
+    std::vector<size_t> cell_cost; ///< number of pair interactions of each cell with itself and half of its neighbours
+    std::vector<double> thread_time; ///< time each thread spent computing short range force
+    std::vector<char> cell_active; ///< cells with at least one particle which needs short range force
+    std::vector<FTYPE_t> par_pos_0[3]; ///< particle positions when Verlet lists were built
+    std::vector<size_t> verlet_start; ///< offsets of particles into Verlet lists, one extra element at the end
+    std::vector<size_t> verlet_j; ///< neighbours of particles (index into packed arrays)
+    std::vector<unsigned char> verlet_shift; ///< periodic image of neighbours, index into 'shift_table'
+    FTYPE_t shift_table[3][27];
 	
 	// METHODS
-	void get_linked_list(const std::vector<Particle_v<FTYPE_t>>& particles)
+    size_t get_cell(const size_t i, const size_t j, const size_t k) const { return (i*M + j)*M + k; }
+
+    size_t get_half_neighbour(const size_t c, const int d, FTYPE_t shift[3]) const
+    {   // neighbouring cell 'd' = 13...26, i.e. (0, 0, 0) and all offsets lexicographically larger,
+        // periodic images are handled by shifting the whole neighbouring cell
+        const size_t cell[3] = {c / (M*M), (c / M) % M, c % M};
+        const int offset[3] = {d / 9 - 1, (d / 3) % 3 - 1, d % 3 - 1};
+        size_t cell_2[3];
+        for (size_t k = 0; k < 3; k++)
+        {
+            const int i = int(cell[k]) + offset[k];
+            cell_2[k] = (i < 0) ? i + M : ((size_t(i) >= M) ? i - M : i);
+            shift[k] = (i < 0) ? -FTYPE_t(per) : ((size_t(i) >= M) ? FTYPE_t(per) : 0);
+        }
+        return get_cell(cell_2[0], cell_2[1], cell_2[2]);
+    }
+
+    static unsigned char get_shift_code(const FTYPE_t shift[3])
     {
-        HOC.assign(-1);
+        unsigned char code = 0;
+        for (size_t k = 0; k < 3; k++) code = 3*code + ((shift[k] > 0) ? 2 : ((shift[k] < 0) ? 0 : 1));
+        return code;
+    }
+
+    size_t get_cell_num(const size_t c) const { return cell_start[c + 1] - cell_start[c]; }
+
+    void get_cell_cost()
+    {   // number of pairs evaluated by every cell, particles have to be sorted
+        const size_t M3 = M*M*M;
+        #pragma omp parallel for
+        for (size_t c = 0; c < M3; c++)
+        {
+            const size_t n = get_cell_num(c);
+            FTYPE_t shift[3];
+            size_t cost = n ? n*(n - 1)/2 : 0;
+            for (int d = 14; d < 27; d++) cost += n*get_cell_num(get_half_neighbour(c, d, shift));
+            cell_cost[c] = cost;
+        }
+    }
+
+    void set_active(const std::vector<char>& active)
+    {   // active particles by their index, all particles are active for empty 'active'
+        const size_t M3 = M*M*M;
+        cell_active.assign(M3, active.empty());
+        if (active.empty()) return;
+
+        #pragma omp parallel for
+        for (size_t c = 0; c < M3; c++)
+        {
+            for (size_t j = cell_start[c]; j < cell_start[c + 1]; j++)
+            {
+                if (active[par_idx[j]])
+                {
+                    cell_active[c] = 1;
+                    break;
+                }
+            }
+        }
+    }
+
+    bool is_active_pair(const size_t c) const
+    {   // whether any particle of cell 'c' or of its half of neighbours is active
+        if (cell_active[c]) return true;
+        FTYPE_t shift[3];
+        for (int d = 14; d < 27; d++) if (cell_active[get_half_neighbour(c, d, shift)]) return true;
+        return false;
+    }
+
+    void get_verlet_lists()
+    {   // pairs closer than 'rs + skin', particles have to be sorted
+        const FTYPE_t r2_max = pow2(rs + skin);
+        const size_t M3 = M*M*M;
+        for (size_t k = 0; k < 3; k++) par_pos_0[k] = par_pos[k];
+        verlet_start.assign(par_num + 1, 0);
+
+        // first count pairs of each particle, then fill them
+        for (int pass = 0; pass < 2; pass++)
+        {
+            #pragma omp parallel for schedule(dynamic, 64)
+            for (size_t c = 0; c < M3; c++)
+            {
+                FTYPE_t shift[3];
+                for (size_t i = cell_start[c]; i < cell_start[c + 1]; i++)
+                {
+                    size_t n = pass ? verlet_start[i] : 0;
+                    for (int d = 13; d < 27; d++)
+                    {
+                        const size_t c_2 = get_half_neighbour(c, d, shift);
+                        const unsigned char s = get_shift_code(shift);
+                        for (size_t j = (d == 13) ? i + 1 : cell_start[c_2]; j < cell_start[c_2 + 1]; j++)
+                        {
+                            const FTYPE_t r2 = pow2(par_pos[0][j] + shift[0] - par_pos[0][i]) + pow2(par_pos[1][j] + shift[1] - par_pos[1][i])
+                                             + pow2(par_pos[2][j] + shift[2] - par_pos[2][i]);
+                            if (r2 < r2_max)
+                            {
+                                if (pass)
+                                {
+                                    verlet_j[n] = j;
+                                    verlet_shift[n] = s;
+                                }
+                                n++;
+                            }
+                        }
+                    }
+                    if (!pass) verlet_start[i + 1] = n;
+                }
+            }
+            if (!pass)
+            {
+                for (size_t i = 0; i < par_num; i++) verlet_start[i + 1] += verlet_start[i];
+                verlet_j.resize(verlet_start[par_num]);
+                verlet_shift.resize(verlet_start[par_num]);
+            }
+        }
+
+        #pragma omp parallel for
+        for (size_t c = 0; c < M3; c++) cell_cost[c] = verlet_start[cell_start[c + 1]] - verlet_start[cell_start[c]];
+    }
+
+    bool update_positions(const std::vector<Particle_v<FTYPE_t>>& particles)
+    {   // update packed positions without sorting, return false when particles have to be sorted again
+        if (!use_verlet || verlet_start.empty()) return false;
+        FTYPE_t max_dr2 = 0;
+
+        #pragma omp parallel for reduction(max:max_dr2)
+        for (size_t j = 0; j < par_num; j++)
+        {   // positions are continuous since the last sort so the cell shifts stay valid
+            const Vec_3D<FTYPE_t> pos_0(par_pos_0[0][j], par_pos_0[1][j], par_pos_0[2][j]);
+            const Vec_3D<FTYPE_t> dr = get_sgn_distance(particles[par_idx[j]].position, pos_0, per);
+            for (size_t k = 0; k < 3; k++) par_pos[k][j] = pos_0[k] + dr[k];
+            max_dr2 = std::max(max_dr2, dr.norm2());
+        }
+        return 4*max_dr2 < pow2(skin);
+    }
+
+    Vec_3D<size_t> get_cell_vec(const Vec_3D<FTYPE_t>& position) const
+    {
+        Vec_3D<FTYPE_t> pos = position/Hc;
+        get_per(pos, M);
+        Vec_3D<size_t> vec;
+        for (size_t i = 0; i < 3; i++) vec[i] = std::min(size_t(pos[i]), M - 1); // guard against rounding at the box edge
+        return vec;
+    }
+
+    size_t get_cell(const Vec_3D<FTYPE_t>& position) const
+    {
+        const Vec_3D<size_t> vec = get_cell_vec(position);
+        return get_cell(vec[0], vec[1], vec[2]);
+    }
+
+	void sort_particles(const std::vector<Particle_v<FTYPE_t>>& particles)
+    {   // parallel counting sort of particles by chaining cell
+        const size_t M3 = M*M*M;
+
+        #pragma omp parallel for
+        for (size_t i = 0; i < par_num; i++) par_cell[i] = get_cell(particles[i].position);
+
+        counting_sort(par_cell, M, cell_start, par_idx);
+
+        // deterministic order within cells, pack positions
+        #pragma omp parallel for schedule(dynamic, 64)
+        for (size_t c = 0; c < M3; c++)
+        {
+            std::sort(par_idx.begin() + cell_start[c], par_idx.begin() + cell_start[c + 1]);
+            for (size_t j = cell_start[c]; j < cell_start[c + 1]; j++)
+            {
+                for (size_t k = 0; k < 3; k++) par_pos[k][j] = particles[par_idx[j]].position[k];
+            }
+        }
+    }
+
+    void update(const std::vector<Particle_v<FTYPE_t>>& particles)
+    {   // sort particles only when Verlet lists are not valid anymore
+        if (update_positions(particles)) return;
+
+        printf("Sorting particles into chaining mesh...\n");
+        sort_particles(particles);
+        if (use_verlet)
+        {
+            printf("Building Verlet lists...\n");
+            get_verlet_lists();
+        }
+    }
+};
+
+/**
+ * @class Octree
+ * @brief Barnes-Hut octree of particles sorted along Morton (Z-order) curve
+ * 
+ * Particles are sorted by their Morton keys: counting sort by the top 'L_top' levels of the tree,
+ * then within these buckets. Top levels are built first, subtrees of buckets are built in parallel
+ * and joined together. Children of a node are stored next to each other. Nodes further than 'rs'
+ * from a particle are skipped, nodes seen under angle smaller than 'theta' act as one particle
+ * in their center of mass.
+ */
+
+class Octree
+{
+public:
+    struct Node
+    {
+        FTYPE_t center[3], half; ///< geometric center and half of the edge of the cube
+        FTYPE_t com[3], mass; ///< center of mass and number of particles
+        size_t first, num; ///< particles in the node
+        size_t first_child, num_child; ///< children, leaf when 'num_child' is zero
+        unsigned level;
+    };
+
+	// CONSTRUCTORS & DESTRUCTOR
+    Octree(size_t par_num, size_t per, FTYPE_t rs, FTYPE_t theta):
+        par_num(par_num), per(per), rs(rs), theta(theta), key(par_num), par_key(par_num), par_bucket(par_num), par_idx(par_num),
+        bucket_start((size_t(1) << 3*L_top) + 1), bucket_node(size_t(1) << 3*L_top), subtrees(size_t(1) << 3*L_top),
+        thread_time(omp_get_max_threads(), 0)
+    {
+        for (size_t k = 0; k < 3; k++)
+        {
+            par_pos[k].resize(par_num);
+            par_force[k].resize(par_num);
+        }
+    }
+
+	// VARIABLES
+    static const unsigned L = 21; ///< bits of Morton keys per dimension
+    static const unsigned L_top = 5; ///< levels of the tree built from buckets of counting sort
+    static const size_t leaf_size = 8; ///< maximal number of particles in leaves
+    size_t par_num, per;
+    FTYPE_t rs, theta;
+    std::vector<uint64_t> key; ///< Morton keys of particles
+    std::vector<uint64_t> par_key; ///< Morton keys sorted along the curve
+    std::vector<size_t> par_bucket, par_idx, bucket_start, bucket_node;
+	std::vector<FTYPE_t> par_pos[3]; ///< particle positions sorted along the curve
+	std::vector<FTYPE_t> par_force[3]; ///< short range force sorted along the curve
+    std::vector<Node> nodes; ///< root is the first node
+    std::vector<std::vector<Node>> subtrees; ///< subtrees of buckets, joined into 'nodes'
+    std::vector<double> thread_time; ///< time each thread spent computing short range force
+
+	// METHODS
+    static uint64_t spread_bits(uint64_t x)
+    {   // insert two zero bits after each of the lowest 21 bits
+        x &= 0x1fffff;
+        x = (x | x << 32) & 0x1f00000000ffff;
+        x = (x | x << 16) & 0x1f0000ff0000ff;
+        x = (x | x << 8) & 0x100f00f00f00f00f;
+        x = (x | x << 4) & 0x10c30c30c30c30c3;
+        x = (x | x << 2) & 0x1249249249249249;
+        return x;
+    }
+
+    uint64_t get_key(Vec_3D<FTYPE_t> pos) const
+    {
+        const uint64_t max_i = (uint64_t(1) << L) - 1;
+        get_per(pos, per);
+        uint64_t key = 0;
+        for (size_t k = 0; k < 3; k++) key |= spread_bits(std::min(uint64_t(pos[k]/per*(max_i + 1)), max_i)) << (2 - k);
+        return key;
+    }
+
+	void sort_particles(const std::vector<Particle_v<FTYPE_t>>& particles)
+    {   // counting sort by top levels, then sort buckets
+        #pragma omp parallel for
         for (size_t i = 0; i < par_num; i++)
         {
-            LL[i] = HOC(particles[i].position/Hc);
-            HOC(particles[i].position/Hc) = i;
+            key[i] = get_key(particles[i].position);
+            par_bucket[i] = key[i] >> 3*(L - L_top);
+        }
+
+        counting_sort(par_bucket, size_t(1) << L_top, bucket_start, par_idx);
+
+        const size_t num_buckets = bucket_start.size() - 1;
+        #pragma omp parallel for schedule(dynamic, 64)
+        for (size_t b = 0; b < num_buckets; b++)
+        {
+            std::sort(par_idx.begin() + bucket_start[b], par_idx.begin() + bucket_start[b + 1],
+                      [&](size_t i_1, size_t i_2){ return (key[i_1] < key[i_2]) || ((key[i_1] == key[i_2]) && (i_1 < i_2)); });
+            for (size_t j = bucket_start[b]; j < bucket_start[b + 1]; j++)
+            {
+                Vec_3D<FTYPE_t> pos = particles[par_idx[j]].position;
+                get_per(pos, per);
+                par_key[j] = key[par_idx[j]];
+                for (size_t k = 0; k < 3; k++) par_pos[k][j] = pos[k];
+            }
+        }
+    }
+
+    static Node get_child(const Node& parent, const unsigned child, const size_t first, const size_t num)
+    {   // octant 'child' of 'parent', bits of 'child' are (x, y, z)
+        Node node;
+        node.half = parent.half / 2;
+        for (size_t k = 0; k < 3; k++) node.center[k] = parent.center[k] + (((child >> (2 - k)) & 1) ? node.half : -node.half);
+        node.first = first;
+        node.num = num;
+        node.first_child = node.num_child = 0;
+        node.level = parent.level + 1;
+        return node;
+    }
+
+    static void get_moments(std::vector<Node>& tree, const size_t n)
+    {   // center of mass of node from its children
+        Node& node = tree[n];
+        node.mass = 0;
+        for (size_t k = 0; k < 3; k++) node.com[k] = 0;
+        for (size_t c = node.first_child; c < node.first_child + node.num_child; c++)
+        {
+            node.mass += tree[c].mass;
+            for (size_t k = 0; k < 3; k++) node.com[k] += tree[c].mass*tree[c].com[k];
+        }
+        for (size_t k = 0; k < 3; k++) node.com[k] /= node.mass;
+    }
+
+    void build_node(std::vector<Node>& tree, const size_t n) const
+    {   // split particles of node 'n' among its children by the next three bits of Morton keys
+        const size_t first = tree[n].first, last = first + tree[n].num;
+        if ((tree[n].num <= leaf_size) || (tree[n].level == L))
+        {
+            tree[n].mass = tree[n].num;
+            for (size_t k = 0; k < 3; k++)
+            {
+                tree[n].com[k] = 0;
+                for (size_t j = first; j < last; j++) tree[n].com[k] += par_pos[k][j];
+                tree[n].com[k] /= tree[n].num;
+            }
+            return;
+        }
+
+        const unsigned shift = 3*(L - tree[n].level - 1);
+        tree[n].first_child = tree.size();
+        for (size_t j = first; j < last; )
+        {
+            const unsigned child = (par_key[j] >> shift) & 7;
+            size_t j_end = j + 1;
+            while ((j_end < last) && (((par_key[j_end] >> shift) & 7) == child)) j_end++;
+            tree.push_back(get_child(tree[n], child, j, j_end - j));
+            tree[n].num_child++;
+            j = j_end;
+        }
+        for (size_t c = tree[n].first_child; c < tree[n].first_child + tree[n].num_child; c++) build_node(tree, c);
+        get_moments(tree, n);
+    }
+
+    void build_top(const size_t n, const size_t prefix)
+    {   // top node 'n' with Morton prefix 'prefix', nodes at level 'L_top' are roots of subtrees
+        if (nodes[n].level == L_top)
+        {
+            bucket_node[prefix] = n;
+            return;
+        }
+
+        const unsigned shift = 3*(L_top - nodes[n].level - 1);
+        std::vector<size_t> child_prefix;
+        nodes[n].first_child = nodes.size();
+        for (unsigned child = 0; child < 8; child++)
+        {
+            const size_t p = (prefix << 3) | child;
+            const size_t first = bucket_start[p << shift], num = bucket_start[(p + 1) << shift] - first;
+            if (!num) continue;
+            nodes.push_back(get_child(nodes[n], child, first, num));
+            nodes[n].num_child++;
+            child_prefix.push_back(p);
+        }
+        for (size_t c = 0; c < nodes[n].num_child; c++) build_top(nodes[n].first_child + c, child_prefix[c]);
+    }
+
+    void build_tree()
+    {   // particles have to be sorted
+        // top levels
+        Node root;
+        for (size_t k = 0; k < 3; k++) root.center[k] = per / FTYPE_t(2);
+        root.half = per / FTYPE_t(2);
+        root.first = 0;
+        root.num = par_num;
+        root.first_child = root.num_child = 0;
+        root.level = 0;
+        nodes.assign(1, root);
+        std::fill(bucket_node.begin(), bucket_node.end(), 0);
+        build_top(0, 0);
+        const size_t num_top = nodes.size();
+
+        // subtrees of buckets
+        const size_t num_buckets = bucket_node.size();
+        #pragma omp parallel for schedule(dynamic, 16)
+        for (size_t b = 0; b < num_buckets; b++)
+        {
+            subtrees[b].clear();
+            if (bucket_start[b] == bucket_start[b + 1]) continue;
+            subtrees[b].push_back(nodes[bucket_node[b]]);
+            build_node(subtrees[b], 0);
         }
+
+        // join subtrees, their roots replace nodes at level 'L_top'
+        std::vector<size_t> offset(num_buckets + 1, 0);
+        for (size_t b = 0; b < num_buckets; b++) offset[b + 1] = offset[b] + (subtrees[b].empty() ? 0 : subtrees[b].size() - 1);
+        nodes.resize(num_top + offset[num_buckets]);
+
+        #pragma omp parallel for schedule(dynamic, 16)
+        for (size_t b = 0; b < num_buckets; b++)
+        {
+            auto get_index = [&](size_t k){ return k ? num_top + offset[b] + k - 1 : bucket_node[b]; };
+            for (size_t k = 0; k < subtrees[b].size(); k++)
+            {
+                Node node = subtrees[b][k];
+                if (node.num_child) node.first_child = get_index(node.first_child);
+                nodes[get_index(k)] = node;
+            }
+        }
+
+        // moments of top levels, children are always stored after their parents
+        for (size_t n = num_top; n-- > 0; ) if (nodes[n].level < L_top) get_moments(nodes, n);
+    }
+
+    void update(const std::vector<Particle_v<FTYPE_t>>& particles)
+    {
+        printf("Building octree...\n");
+        sort_particles(particles);
+        build_tree();
     }
 };
 
-FTYPE_t force_ref(const FTYPE_t r, const FTYPE_t a){
-	// Reference force for an S_2-shaped particle
-	FTYPE_t z = 2 * r / a;
-	if (z > 2) return 1 / (r*r);
-	else if (z > 1) return (12 / (z*z) - 224 + 896 * z - 840 * z*z + 224 * pow(z, 3) +
-							70 * pow(z, 4) - 48 * pow(z, 5) + 7 * pow(z, 6)) / (35 * a*a);
-	else return (224 * z - 224 * pow(z, 3) + 70 * pow(z, 4) + 48 * pow(z, 5) - 21 * pow(z, 7)) / (35 * a*a);
+void force_cell_pair(Chaining_Mesh& chaining_mesh, const Force_Table& force_table, const size_t c_1, const size_t c_2,
+                     const FTYPE_t shift[3])
+{   // short range force between particles in two cells, particles in 'c_2' are shifted by 'shift',
+    // both particles of a pair are updated (Newton`s third law), pairs within the same cell are counted once
+    const FTYPE_t* const x = chaining_mesh.par_pos[0].data();
+    const FTYPE_t* const y = chaining_mesh.par_pos[1].data();
+    const FTYPE_t* const z = chaining_mesh.par_pos[2].data();
+    FTYPE_t* const f_x = chaining_mesh.par_force[0].data();
+    FTYPE_t* const f_y = chaining_mesh.par_force[1].data();
+    FTYPE_t* const f_z = chaining_mesh.par_force[2].data();
+    const bool self = (c_1 == c_2) && !shift[0] && !shift[1] && !shift[2];
+    const size_t j_end = chaining_mesh.cell_start[c_2 + 1];
+
+    for (size_t i = chaining_mesh.cell_start[c_1]; i < chaining_mesh.cell_start[c_1 + 1]; i++)
+    {
+        const FTYPE_t x_i = x[i] - shift[0], y_i = y[i] - shift[1], z_i = z[i] - shift[2];
+        FTYPE_t f_x_i = 0, f_y_i = 0, f_z_i = 0;
+
+        #pragma omp simd reduction(+:f_x_i, f_y_i, f_z_i)
+        for (size_t j = self ? i + 1 : chaining_mesh.cell_start[c_2]; j < j_end; j++)
+        {
+            const FTYPE_t dx = x[j] - x_i, dy = y[j] - y_i, dz = z[j] - z_i;
+            const FTYPE_t f = force_table.eval(dx*dx + dy*dy + dz*dz);
+            f_x_i += f*dx;
+            f_y_i += f*dy;
+            f_z_i += f*dz;
+            f_x[j] -= f*dx;
+            f_y[j] -= f*dy;
+            f_z[j] -= f*dz;
+        }
+        f_x[i] += f_x_i;
+        f_y[i] += f_y_i;
+        f_z[i] += f_z_i;
+    }
 }
 
-FTYPE_t force_tot(const FTYPE_t r, const FTYPE_t e2){
-	return 1 / (r*r+e2);
+void force_verlet(Chaining_Mesh& chaining_mesh, const Force_Table& force_table, const size_t c)
+{   // short range force between particles in cell 'c' and their neighbours from Verlet lists (Newton`s third law),
+    // every particle is at most once in each list so the updates of neighbours do not collide
+    const FTYPE_t* const x = chaining_mesh.par_pos[0].data();
+    const FTYPE_t* const y = chaining_mesh.par_pos[1].data();
+    const FTYPE_t* const z = chaining_mesh.par_pos[2].data();
+    FTYPE_t* const f_x = chaining_mesh.par_force[0].data();
+    FTYPE_t* const f_y = chaining_mesh.par_force[1].data();
+    FTYPE_t* const f_z = chaining_mesh.par_force[2].data();
+    const FTYPE_t* const s_x = chaining_mesh.shift_table[0];
+    const FTYPE_t* const s_y = chaining_mesh.shift_table[1];
+    const FTYPE_t* const s_z = chaining_mesh.shift_table[2];
+    const size_t* const verlet_j = chaining_mesh.verlet_j.data();
+    const unsigned char* const verlet_shift = chaining_mesh.verlet_shift.data();
+
+    for (size_t i = chaining_mesh.cell_start[c]; i < chaining_mesh.cell_start[c + 1]; i++)
+    {
+        const FTYPE_t x_i = x[i], y_i = y[i], z_i = z[i];
+        FTYPE_t f_x_i = 0, f_y_i = 0, f_z_i = 0;
+
+        #pragma omp simd reduction(+:f_x_i, f_y_i, f_z_i)
+        for (size_t n = chaining_mesh.verlet_start[i]; n < chaining_mesh.verlet_start[i + 1]; n++)
+        {
+            const size_t j = verlet_j[n];
+            const unsigned char s = verlet_shift[n];
+            const FTYPE_t dx = x[j] + s_x[s] - x_i, dy = y[j] + s_y[s] - y_i, dz = z[j] + s_z[s] - z_i;
+            const FTYPE_t f = force_table.eval(dx*dx + dy*dy + dz*dz);
+            f_x_i += f*dx;
+            f_y_i += f*dy;
+            f_z_i += f*dz;
+            f_x[j] -= f*dx;
+            f_y[j] -= f*dy;
+            f_z[j] -= f*dz;
+        }
+        f_x[i] += f_x_i;
+        f_y[i] += f_y_i;
+        f_z[i] += f_z_i;
+    }
 }
 
-void force_short(const Sim_Param &sim, const FTYPE_t D, const LinkedList& linked_list, const  std::vector<Particle_v<FTYPE_t>>& particles,
-				 const Vec_3D<FTYPE_t>& position, Vec_3D<FTYPE_t>& force, Interp_obj& fs_interp)
-{	// Calculate short range force in position, force is added
-    #define FORCE_SHORT_NO_INTER
-	size_t p;
-	Vec_3D<FTYPE_t> dr_vec;
-    FTYPE_t dr2;
-    FTYPE_t dr; // <-- #ifdef FORCE_SHORT_NO_INTER
-    const FTYPE_t m = pow((FTYPE_t)sim.box_opt.Ng, 3) / D;
-    const size_t Nm = sim.box_opt.mesh_num;
-    const FTYPE_t rs2 = pow2(sim.app_opt.rs);
-    const FTYPE_t e2 = pow2(sim.box_opt.Ng*0.1); // <-- #ifdef FORCE_SHORT_NO_INTER
-
-    IT<3> it(position, sim.app_opt.Hc);
-    do{
-        p = linked_list.HOC(it.vec);
-        while (p != -1){
-            dr_vec = get_sgn_distance(particles[p].position, position, Nm);
-            dr2 = dr_vec.norm2();
-            if ((dr2 < rs2) && (dr2 != 0)) // Short range force is set 0 for separation larger than cutoff radius
+void force_short(Chaining_Mesh& chaining_mesh, const Force_Table& force_table, const FTYPE_t m,
+                 const std::vector<char>& active = std::vector<char>())
+{   // Calculate short range force (in units of mass 'm') of active particles (all for empty 'active'), particles have to be sorted
+    // pairs between cells without active particles are skipped, forces of other particles are not valid then
+    for (size_t k = 0; k < 3; k++) std::fill(chaining_mesh.par_force[k].begin(), chaining_mesh.par_force[k].end(), 0);
+    if (!chaining_mesh.use_verlet) chaining_mesh.get_cell_cost(); // costs of Verlet lists are computed with the lists
+    chaining_mesh.set_active(active);
+    const std::vector<char>& cell_active = chaining_mesh.cell_active;
+    const std::vector<size_t>& cell_cost = chaining_mesh.cell_cost;
+
+    // every cell interacts with itself and with half of its neighbours, the other half is covered by the neighbours
+    std::vector<size_t> cells;
+    for (const auto& color : chaining_mesh.color_cells)
+    {
+        // skip cells without work, the most expensive first
+        cells.clear();
+        for (size_t c : color) if (cell_cost[c]) cells.push_back(c);
+        std::sort(cells.begin(), cells.end(), [&](size_t c_1, size_t c_2){ return cell_cost[c_1] > cell_cost[c_2]; });
+        const size_t num_cells = cells.size();
+
+        #pragma omp parallel
+        {
+            const double t_start = omp_get_wtime();
+            #pragma omp for schedule(dynamic) nowait
+            for (size_t n = 0; n < num_cells; n++)
             {
-                #ifdef FORCE_SHORT_NO_INTER
-                dr = sqrt(dr2);
-                force += dr_vec*(force_tot(dr, e2) - force_ref(dr, sim.app_opt.a))*m/(dr*4*PI);
-                #else
-                force += dr_vec*(m/sqrt(dr2)*fs_interp.eval(dr2));
-                #endif
+                if (chaining_mesh.use_verlet)
+                {
+                    if (chaining_mesh.is_active_pair(cells[n])) force_verlet(chaining_mesh, force_table, cells[n]);
+                    continue;
+                }
+                FTYPE_t shift[3];
+                for (int d = 13; d < 27; d++)
+                {
+                    const size_t c_2 = chaining_mesh.get_half_neighbour(cells[n], d, shift);
+                    if (cell_active[cells[n]] || cell_active[c_2]) force_cell_pair(chaining_mesh, force_table, cells[n], c_2, shift);
+                }
             }
-            p = linked_list.LL[p];
+            chaining_mesh.thread_time[omp_get_thread_num()] += omp_get_wtime() - t_start;
         }
-    } while( it.iter() );
+    }
+
+    for (size_t k = 0; k < 3; k++)
+    {
+        FTYPE_t* const f = chaining_mesh.par_force[k].data();
+        #pragma omp parallel for simd
+        for (size_t j = 0; j < chaining_mesh.par_num; j++) f[j] *= m;
+    }
 }
 
-void kick_step_w_pp(const Sim_Param &sim, const FTYPE_t a, const FTYPE_t da,  std::vector<Particle_v<FTYPE_t>>& particles, const  std::vector< Mesh> &force_field,
-                    LinkedList& linked_list, Interp_obj& fs_interp)
+void force_leaf(const Octree& octree, const Force_Table& force_table, const Octree::Node& node, const FTYPE_t x[3],
+                const FTYPE_t shift[3], FTYPE_t force[3])
+{   // short range force from all particles in leaf, leaf is shifted by 'shift'
+    const FTYPE_t* const x_j = octree.par_pos[0].data();
+    const FTYPE_t* const y_j = octree.par_pos[1].data();
+    const FTYPE_t* const z_j = octree.par_pos[2].data();
+    const FTYPE_t x_i = x[0] - shift[0], y_i = x[1] - shift[1], z_i = x[2] - shift[2];
+    FTYPE_t f_x = 0, f_y = 0, f_z = 0;
+
+    #pragma omp simd reduction(+:f_x, f_y, f_z)
+    for (size_t j = node.first; j < node.first + node.num; j++)
+    {
+        const FTYPE_t dx = x_j[j] - x_i, dy = y_j[j] - y_i, dz = z_j[j] - z_i;
+        const FTYPE_t f = force_table.eval(dx*dx + dy*dy + dz*dz);
+        f_x += f*dx;
+        f_y += f*dy;
+        f_z += f*dz;
+    }
+    force[0] += f_x;
+    force[1] += f_y;
+    force[2] += f_z;
+}
+
+void force_short(Octree& octree, const Force_Table& force_table, const FTYPE_t m, const std::vector<char>& active = std::vector<char>())
+{   // Calculate short range force (in units of mass 'm') of active particles (all for empty 'active') by walking the tree,
+    // tree has to be built
+    const FTYPE_t per = octree.per;
+    const FTYPE_t rs2 = pow2(octree.rs), theta2 = pow2(octree.theta);
+    const std::vector<Octree::Node>& nodes = octree.nodes;
+
+    #pragma omp parallel
+    {
+        const double t_start = omp_get_wtime();
+        std::vector<size_t> stack;
+
+        #pragma omp for schedule(dynamic, 256) nowait
+        for (size_t j = 0; j < octree.par_num; j++)
+        {
+            if (!active.empty() && !active[octree.par_idx[j]]) continue;
+            const FTYPE_t x[3] = {octree.par_pos[0][j], octree.par_pos[1][j], octree.par_pos[2][j]};
+            FTYPE_t force[3] = {0, 0, 0};
+            stack.assign(1, 0);
+            while (!stack.empty())
+            {
+                const Octree::Node& node = nodes[stack.back()];
+                stack.pop_back();
+
+                // nearest periodic image of the node and distance of the particle from its cube
+                FTYPE_t shift[3], r2_min = 0;
+                for (size_t k = 0; k < 3; k++)
+                {
+                    const FTYPE_t d = node.center[k] - x[k];
+                    shift[k] = -per*std::round(d/per);
+                    r2_min += pow2(std::max(std::abs(d + shift[k]) - node.half, FTYPE_t(0)));
+                }
+                if (r2_min >= rs2) continue; // Short range force is set 0 for separation larger than cutoff radius
+
+                if (!node.num_child)
+                {
+                    force_leaf(octree, force_table, node, x, shift, force);
+                    continue;
+                }
+
+                const FTYPE_t dr[3] = {node.com[0] + shift[0] - x[0], node.com[1] + shift[1] - x[1], node.com[2] + shift[2] - x[2]};
+                const FTYPE_t r2 = pow2(dr[0]) + pow2(dr[1]) + pow2(dr[2]);
+                if ((r2_min > 0) && (4*pow2(node.half) < theta2*r2))
+                {   // far enough, whole node acts as one particle
+                    const FTYPE_t f = node.mass*force_table.eval(r2);
+                    for (size_t k = 0; k < 3; k++) force[k] += f*dr[k];
+                }
+                else for (size_t c = node.first_child; c < node.first_child + node.num_child; c++) stack.push_back(c);
+            }
+            for (size_t k = 0; k < 3; k++) octree.par_force[k][j] = m*force[k];
+        }
+        octree.thread_time[omp_get_thread_num()] += omp_get_wtime() - t_start;
+    }
+}
+
+template<class T>
+void kick_step_w_pp(const Sim_Param &sim, const Integ_Coeff& coeff,  std::vector<Particle_v<FTYPE_t>>& particles, const  std::vector< Mesh> &force_field,
+                    T& short_range, const Force_Table& force_table)
 {    // 2nd order ODE with long & short range potential
     const size_t Np = particles.size();
     Vec_3D<FTYPE_t> force;
-    const FTYPE_t D = growth_factor(a, sim.cosmo);
-    const FTYPE_t OL = sim.cosmo.Omega_L()*pow(a,3);
-    const FTYPE_t Om = sim.cosmo.Omega_m;
-    // -3/2a represents usual EOM, the rest are LCDM corrections
-    const FTYPE_t f1 = 3/(2*a)*(Om+2*OL)/(Om+OL);
-    const FTYPE_t f2 = 3/(2*a)*Om/(Om+OL)*D/a;
+    const FTYPE_t D = growth_factor(coeff.a_half, sim.cosmo);
+    const FTYPE_t m = pow((FTYPE_t)sim.box_opt.Ng, 3) / D;
     
-    printf("Creating linked list...\n");
-	linked_list.get_linked_list(particles);
+    short_range.update(particles);
+
+    std::cout << "Computing short range part of the potential...\n";
+    force_short(short_range, force_table, m);
+    print_thread_time(short_range.thread_time);
 
-    std::cout << "Computing short and long range parts of the potential...\n";
+    std::cout << "Computing long range part of the potential...\n";
     #pragma omp parallel for private(force)
-    for (size_t i = 0; i < Np; i++)
+    for (size_t j = 0; j < Np; j++)
 	{
-        force.fill(0.);
+        const size_t i = short_range.par_idx[j];
+        for (size_t k = 0; k < 3; k++) force[k] = short_range.par_force[k][j]; // short range force
         assign_from(force_field, particles[i].position, force); // long-range force
-        force_short(sim, D, linked_list, particles, particles[i].position, force, fs_interp); // short range force
+        particles[i].velocity = particles[i].velocity*coeff.kick_v + force*coeff.kick_F;
+    }
+}
+
+/**
+ * @class Block_Steps
+ * @brief hierarchical (block) time-steps of short range force
+ * 
+ * Particles are binned by their short range acceleration, particles in bin 'b' are kicked by the short range
+ * force '2^b' times per time-step. The long range (mesh) force together with the friction term kicks all particles
+ * at the beginning and at the end of the time-step, all particles drift together in the smallest sub-steps.
+ */
+
+class Block_Steps
+{
+public:
+	// CONSTRUCTORS & DESTRUCTOR
+    Block_Steps(size_t par_num, unsigned levels, FTYPE_t eta, FTYPE_t eps):
+        levels(levels), eta(eta), eps(eps), par_bin(par_num, 0), active(par_num, 0), force(par_num), a_force(-1) {}
+
+	// VARIABLES
+    unsigned levels; ///< maximal bin, time-step is divided into '2^levels' sub-steps
+    FTYPE_t eta, eps; ///< accuracy parameter and softening length of time-step criterion
+    std::vector<unsigned> par_bin; ///< bin of each particle
+    std::vector<char> active; ///< particles kicked at current sub-step
+    std::vector<Vec_3D<FTYPE_t>> force; ///< short range force by particle index
+    FTYPE_t a_force; ///< time of the last evaluation of short range force of all particles
+};
+
+template<class T>
+void get_force_short(const Sim_Param &sim, const FTYPE_t a, const std::vector<Particle_v<FTYPE_t>>& particles, T& short_range,
+                     const Force_Table& force_table, const std::vector<char>& active, std::vector<Vec_3D<FTYPE_t>>& force)
+{   // short range force at time 'a' of active particles (all for empty 'active'), stored by particle index
+    const size_t Np = particles.size();
+    const FTYPE_t m = pow((FTYPE_t)sim.box_opt.Ng, 3) / growth_factor(a, sim.cosmo);
+
+    short_range.update(particles);
+    force_short(short_range, force_table, m, active);
+    print_thread_time(short_range.thread_time);
+
+    #pragma omp parallel for
+    for (size_t j = 0; j < Np; j++)
+    {
+        const size_t i = short_range.par_idx[j];
+        if (active.empty() || active[i]) for (size_t k = 0; k < 3; k++) force[i][k] = short_range.par_force[k][j];
+    }
+}
 
-        force = force*f2 - particles[i].velocity*f1;		
-        particles[i].velocity += force*da;
+template<class T>
+void block_step_w_pp(const Sim_Param &sim, const FTYPE_t a, const FTYPE_t da, std::vector<Particle_v<FTYPE_t>>& particles,
+                     const std::vector< Mesh> &force_field, T& short_range, const Force_Table& force_table, Block_Steps& block)
+{   // Kick-Drift-Kick from 'a - da' to 'a', long range kicks on the time-step, short range kicks sub-cycled in bins
+    const size_t Np = particles.size();
+    const size_t per = sim.box_opt.mesh_num;
+    const unsigned n = block.levels;
+    const size_t num_sub = size_t(1) << n;
+    const FTYPE_t a_0 = a - da, h = da / num_sub;
+    const std::vector<char> all;
+
+    // short range force of all particles at the beginning, unless known from the end of the previous time-step
+    if (std::abs(block.a_force - a_0) > 1E-6*da)
+    {
+        std::cout << "Computing short range part of the potential...\n";
+        get_force_short(sim, a_0, particles, short_range, force_table, all, block.force);
+    }
+
+    // bins by short range acceleration, time-step criterion da_i = sqrt(2*eta*eps/|dv/da|)
+    const FTYPE_t acc_norm = Integ_Coeff(sim, a, da).kick_F / da;
+    std::vector<size_t> bin_num(n + 1, 0);
+    #pragma omp parallel for
+    for (size_t i = 0; i < Np; i++)
+    {
+        const FTYPE_t acc = block.force[i].norm()*acc_norm;
+        const FTYPE_t da_i = (acc > 0) ? sqrt(2*block.eta*block.eps/acc) : da;
+        block.par_bin[i] = (da_i < da) ? std::min(n, unsigned(ceil(log2(da/da_i)))) : 0;
     }
+    for (size_t i = 0; i < Np; i++) bin_num[block.par_bin[i]]++;
+    printf("Particles in bins of time-steps:");
+    for (unsigned b = 0; b <= n; b++) printf(" %lu", bin_num[b]);
+    printf("\n");
+
+    // long range kick over the first half of the time-step
+    std::cout << "Computing long range part of the potential...\n";
+    kick_step_w_momentum(Integ_Coeff(sim, a_0 + da/2, da/2), particles, force_field);
+
+    for (size_t s = 0; s <= num_sub; s++)
+    {
+        const FTYPE_t t = (s == num_sub) ? a : a_0 + s*h;
+
+        // bin 'b' is active at multiples of '2^(n-b)' sub-steps
+        unsigned min_bin = 0;
+        if (s && (s < num_sub))
+        {
+            unsigned tz = 0;
+            while (!((s >> tz) & 1)) tz++;
+            min_bin = n - tz;
+            #pragma omp parallel for
+            for (size_t i = 0; i < Np; i++) block.active[i] = (block.par_bin[i] >= min_bin);
+            get_force_short(sim, t, particles, short_range, force_table, block.active, block.force);
+        }
+        else if (s == num_sub)
+        {
+            get_force_short(sim, t, particles, short_range, force_table, all, block.force);
+            block.a_force = a;
+        }
+
+        // short range kick of active bins over the half of their sub-steps around 't'
+        std::vector<FTYPE_t> kick_F(n + 1, 0);
+        for (unsigned b = min_bin; b <= n; b++)
+        {
+            const FTYPE_t h_b = da / (size_t(1) << b);
+            const FTYPE_t t_0 = std::max(a_0, t - h_b/2), t_1 = std::min(a, t + h_b/2);
+            kick_F[b] = Integ_Coeff(sim, t_1, t_1 - t_0).kick_F;
+        }
+        #pragma omp parallel for
+        for (size_t i = 0; i < Np; i++)
+        {
+            const unsigned b = block.par_bin[i];
+            if (b >= min_bin) particles[i].velocity += block.force[i]*kick_F[b];
+        }
+
+        // all particles drift together
+        if (s < num_sub)
+        {
+            const Integ_Coeff coeff(sim, t + h, h);
+            stream_step(coeff.stream_1 + coeff.stream_2, particles);
+            get_per(particles, per);
+        }
+    }
+
+    // long range kick over the second half of the time-step
+    std::cout << "Computing long range part of the potential...\n";
+    kick_step_w_momentum(Integ_Coeff(sim, a, da/2), particles, force_field);
 }
 
 }// end of anonymous namespace
@@ -127,30 +978,35 @@ void kick_step_w_pp(const Sim_Param &sim, const FTYPE_t a, const FTYPE_t da,  st
 class App_Var_FP_mod::FP_ppImpl
 {
 public:
-    FP_ppImpl(const Sim_Param &sim): linked_list(sim.box_opt.par_num, sim.app_opt.M, sim.app_opt.Hc)
+    FP_ppImpl(const Sim_Param &sim):
+        force_table(sim.app_opt.rs, sim.app_opt.a, pow2(sim.box_opt.Ng*0.1)) // softening of 10% of average interparticle length
     {
-        memory_alloc = sizeof(size_t)*(linked_list.HOC.length+linked_list.par_num);
-
-        // precompute short range force
-        size_t res = size_t(sim.app_opt.rs/0.05)+1; // force resolution 5% of mesh cell
-        const FTYPE_t r0 = sim.app_opt.rs / (res-1);
-        Data_Vec<FTYPE_t, 2> data(res);
-        FTYPE_t r;
-        const FTYPE_t e2 = pow2(sim.box_opt.Ng*0.1); // softening of 10% of average interparticle length
-
-        #pragma omp parallel for private(r)
-        for(size_t i = 0; i < res; i++)
+        const size_t par_num = sim.box_opt.par_num;
+        memory_alloc = sizeof(FTYPE_t)*force_table.data.size();
+        if (sim.app_opt.block_levels)
+        {
+            block_steps.reset(new Block_Steps(par_num, sim.app_opt.block_levels, sim.app_opt.block_eta, sim.box_opt.Ng*0.1));
+            memory_alloc += (sizeof(unsigned) + sizeof(char) + sizeof(Vec_3D<FTYPE_t>))*par_num;
+        }
+        if (sim.app_opt.tree)
+        {   // nodes of the tree are not included
+            octree.reset(new Octree(par_num, sim.box_opt.mesh_num, sim.app_opt.rs, sim.app_opt.theta));
+            memory_alloc += sizeof(size_t)*(octree->bucket_start.size() + octree->bucket_node.size() + 2*par_num)
+                          + sizeof(uint64_t)*2*par_num + sizeof(FTYPE_t)*6*par_num;
+        }
+        else
         {
-            r = i*r0;
-            data[0][i] = pow2(r); // store square of r
-            data[1][i] = (force_tot(r, e2) - force_ref(r, sim.app_opt.a))/(4*PI);
+            chaining_mesh.reset(new Chaining_Mesh(par_num, sim.app_opt.M, sim.app_opt.Hc, sim.box_opt.mesh_num, sim.app_opt.rs, sim.app_opt.skin));
+            memory_alloc += sizeof(size_t)*(chaining_mesh->cell_start.size() + 2*par_num)
+                          + sizeof(FTYPE_t)*((chaining_mesh->use_verlet ? 9 : 6)*par_num);
         }
-        fs_interp.init(data);
     }
 
 	// VARIABLES
-    LinkedList linked_list;
-    Interp_obj fs_interp;
+    std::unique_ptr<Chaining_Mesh> chaining_mesh; ///< P3M short range force
+    std::unique_ptr<Octree> octree; ///< tree-PM short range force
+    std::unique_ptr<Block_Steps> block_steps; ///< hierarchical time-steps of short range force
+    Force_Table force_table;
     uint64_t memory_alloc;
 };
 
@@ -174,7 +1030,18 @@ void App_Var_FP_mod::pot_corr()
 }
 
 void App_Var_FP_mod::upd_pos()
-{// Leapfrog method for modified frozen-potential
-    auto kick_step = [&](){ kick_step_w_pp(sim, a_half(), da(), particles, app_field, m_impl->linked_list, m_impl->fs_interp); };
-    stream_kick_stream(da(), particles, kick_step, sim.box_opt.mesh_num);
+{// Symplectic integrator for modified frozen-potential
+    if (m_impl->block_steps)
+    {
+        Block_Steps& block = *m_impl->block_steps;
+        if (m_impl->octree) block_step_w_pp(sim, a(), da(), particles, app_field, *m_impl->octree, m_impl->force_table, block);
+        else block_step_w_pp(sim, a(), da(), particles, app_field, *m_impl->chaining_mesh, m_impl->force_table, block);
+        return;
+    }
+
+    auto kick_step = [&](const Integ_Coeff& coeff){
+        if (m_impl->octree) kick_step_w_pp(sim, coeff, particles, app_field, *m_impl->octree, m_impl->force_table);
+        else kick_step_w_pp(sim, coeff, particles, app_field, *m_impl->chaining_mesh, m_impl->force_table);
+    };
+    symplectic_step(sim, a(), da(), particles, kick_step, sim.box_opt.mesh_num);
 }
\ No newline at end of file
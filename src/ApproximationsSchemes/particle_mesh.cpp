@@ -0,0 +1,30 @@
+/**
+ * @brief particle-mesh N-body simulation implementation
+ * 
+ * @file particle_mesh.cpp
+ */
+
+#include "particle_mesh.hpp"
+#include "core_app.h"
+#include "core_mesh.h"
+#include "core_power.h"
+#include "integration.hpp"
+#include "params.hpp"
+
+App_Var_PM::App_Var_PM(const Sim_Param &sim):
+    App_Var<Particle_v<FTYPE_t>>(sim, "PM", "Particle-mesh N-body simulation") {}
+
+void App_Var_PM::pot_corr()
+{
+    /* Potential is computed from particle positions at every step */
+}
+
+void App_Var_PM::upd_pos()
+{// Symplectic integrator with force recomputed every step
+    auto kick_step = [&](const Integ_Coeff& coeff){
+        get_per(particles, sim.box_opt.mesh_num);
+        get_force_from_par(particles, app_field, sim, growth_factor(coeff.a_half, sim.cosmo), p_F, p_B);
+        kick_step_w_momentum(coeff, particles, app_field);
+    };
+    symplectic_step(sim, a(), da(), particles, kick_step, sim.box_opt.mesh_num);
+}
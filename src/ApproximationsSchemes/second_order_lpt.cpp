@@ -0,0 +1,28 @@
+/**
+ * @brief second-order Lagrangian perturbation theory implementation
+ * 
+ * @file second_order_lpt.cpp
+ */
+
+#include "second_order_lpt.hpp"
+#include "core_app.h"
+#include "core_mesh.h"
+#include "params.hpp"
+
+App_Var_LPT2::App_Var_LPT2(const Sim_Param &sim):
+    App_Var<Particle_v<FTYPE_t>>(sim, "LPT2", "Second-order Lagrangian perturbation theory", true) {}
+
+void App_Var_LPT2::upd_pos()
+{// 2LPT with velocitites
+    set_pert_pos(sim, a(), particles, app_field, app_field_2);
+}
+
+bool App_Var_LPT2::is_analytic() const
+{
+    return true;
+}
+
+void App_Var_LPT2::pot_corr()
+{
+    return;
+}
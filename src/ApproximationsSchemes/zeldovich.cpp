@@ -18,6 +18,11 @@ void App_Var_ZA::upd_pos()
     set_pert_pos(sim, a(), particles, app_field);
 }
 
+bool App_Var_ZA::is_analytic() const
+{
+    return true;
+}
+
 void App_Var_ZA::pot_corr()
 {
     return;
@@ -160,6 +160,107 @@ void set_pert_pos(const Sim_Param &sim, const FTYPE_t a, std::vector<Particle_v<
 	}
 }
 
+/**
+ * @brief set positions of particles according to 2LPT, \f$ x = q + D\Psi^{(1)} + D_2\Psi^{(2)} \f$
+ * 
+ * @param sim simulation parameters
+ * @param a scale factor
+ * @param particles particles to set
+ * @param vel_field first-order displacement field in q-space
+ * @param vel_field_2 second-order displacement field in q-space
+ */
+void set_pert_pos(const Sim_Param &sim, const FTYPE_t a, std::vector<Particle_x<FTYPE_t>>& particles, const std::vector< Mesh> &vel_field,
+                  const std::vector< Mesh> &vel_field_2)
+{
+    printf("\nSetting initial positions of particles (2LPT)...\n");
+	Vec_3D<size_t> unpert_pos;
+	Vec_3D<FTYPE_t> displ_1, displ_2;
+	Vec_3D<FTYPE_t> pert_pos;
+	
+	const size_t par_per_dim = sim.box_opt.par_num_1d;
+	const size_t Ng = sim.box_opt.Ng;
+    const size_t Nm = sim.box_opt.mesh_num;
+    const size_t Np = sim.box_opt.par_num;
+
+    const FTYPE_t D = growth_factor(a, sim.cosmo); // growth factor
+    const FTYPE_t D_2 = growth_factor_2(a, sim.cosmo); // second-order growth factor
+
+	#pragma omp parallel for private(unpert_pos, displ_1, displ_2, pert_pos)
+	for(size_t i=0; i< Np; i++)
+	{
+		set_unpert_pos_one_par(unpert_pos, i, par_per_dim, Ng);
+		set_velocity_one_par(unpert_pos, displ_1, vel_field);
+		set_velocity_one_par(unpert_pos, displ_2, vel_field_2);
+		pert_pos = displ_1*D + displ_2*D_2 + unpert_pos;
+		get_per(pert_pos, Nm);
+		particles[i] = Particle_x<FTYPE_t>(pert_pos);
+	}
+}
+
+/**
+ * @brief set positions and velocities of particles according to 2LPT, \f$ x = q + D\Psi^{(1)} + D_2\Psi^{(2)} \f$
+ * 
+ * @param sim simulation parameters
+ * @param a scale factor
+ * @param particles particles to set
+ * @param vel_field first-order displacement field in q-space
+ * @param vel_field_2 second-order displacement field in q-space
+ */
+void set_pert_pos(const Sim_Param &sim, const FTYPE_t a, std::vector<Particle_v<FTYPE_t>>& particles, const std::vector< Mesh> &vel_field,
+                  const std::vector< Mesh> &vel_field_2)
+{
+    printf("\nSetting initial positions and velocitis of particles (2LPT)...\n");
+	Vec_3D<size_t> unpert_pos;
+	Vec_3D<FTYPE_t> displ_1, displ_2;
+	Vec_3D<FTYPE_t> pert_pos;
+	
+	const size_t par_per_dim = sim.box_opt.par_num_1d;
+	const size_t Ng = sim.box_opt.Ng;
+    const size_t Nm = sim.box_opt.mesh_num;
+    const size_t Np = sim.box_opt.par_num;
+
+    const FTYPE_t D = growth_factor(a, sim.cosmo); // growth factor
+    const FTYPE_t dDda = growth_change(a, sim.cosmo); // dD / da
+    const FTYPE_t D_2 = growth_factor_2(a, sim.cosmo); // second-order growth factor
+    const FTYPE_t dD2da = growth_change_2(a, sim.cosmo); // dD_2 / da
+
+	#pragma omp parallel for private(unpert_pos, displ_1, displ_2, pert_pos)
+	for(size_t i=0; i< Np; i++)
+	{
+		set_unpert_pos_one_par(unpert_pos, i, par_per_dim, Ng);
+		set_velocity_one_par(unpert_pos, displ_1, vel_field);
+		set_velocity_one_par(unpert_pos, displ_2, vel_field_2);
+		pert_pos = displ_1*D + displ_2*D_2 + unpert_pos;
+		get_per(pert_pos, Nm);
+		particles[i] = Particle_v<FTYPE_t>(pert_pos, displ_1*dDda + displ_2*dD2da);
+	}
+}
+
+/**
+ * @brief store Lagrangian displacement field at unperturbed positions of particles
+ * 
+ * @param sim simulation parameters
+ * @param displ displacement of each particle, ordered in the same way as particles
+ * @param vel_field displacement field in q-space
+ */
+void get_lagr_displ(const Sim_Param &sim, std::vector<Vec_3D<FTYPE_t>>& displ, const std::vector< Mesh> &vel_field)
+{
+    printf("Storing Lagrangian displacement of particles...\n");
+	Vec_3D<size_t> unpert_pos;
+
+	const size_t par_per_dim = sim.box_opt.par_num_1d;
+	const size_t Ng = sim.box_opt.Ng;
+    const size_t Np = sim.box_opt.par_num;
+    displ.resize(Np);
+
+	#pragma omp parallel for private(unpert_pos)
+	for(size_t i=0; i< Np; i++)
+	{
+		set_unpert_pos_one_par(unpert_pos, i, par_per_dim, Ng);
+		set_velocity_one_par(unpert_pos, displ[i], vel_field);
+	}
+}
+
 static void gen_gauss_white_noise(const Sim_Param &sim, Mesh& rho)
 {
 	// Get keys for each slab in the x axis that this rank contains
@@ -600,6 +701,145 @@ void gen_displ_k(std::vector<Mesh>& vel_field, const Mesh& pot_k) {gen_displ_k_S
 
 void gen_displ_k_cic(std::vector<Mesh>& vel_field, const Mesh& pot_k) {gen_displ_k_S2(vel_field, pot_k, 0.);}
 
+/**
+ * @brief second derivative of potential in k-space, \f$ \phi_{,ij} = -k_i k_j \phi \f$
+ */
+static void gen_pot_deriv_k(Mesh& deriv_k, const Mesh& pot_k, const size_t i, const size_t j)
+{
+    Vec_3D<int> k_vec;
+    FTYPE_t k_ij;
+    const size_t N = deriv_k.N;
+    const FTYPE_t d2_k = pow2(2*PI/N); // factor from second derivative with respect to the mesh coordinates
+    const size_t l_half = deriv_k.length/2;
+
+	#pragma omp parallel for private(k_vec, k_ij)
+	for(size_t l=0; l < l_half; l++)
+	{
+        get_k_vec(N, l, k_vec);
+        k_ij = -k_vec[i]*k_vec[j]*d2_k;
+        deriv_k[2*l] = k_ij*pot_k[2*l];
+        deriv_k[2*l+1] = k_ij*pot_k[2*l+1];
+    }
+}
+
+/**
+ * @brief compute second-order displacement field \f$ \Psi^{(2)} = \nabla\phi^{(2)} \f$ in q-space
+ * 
+ * @param vel_field_2 second-order displacement field, all three meshes are used as temporary storage
+ * @param pot_k first-order potential in k-space (not modified)
+ * @param p_F plan for forward transformation
+ * @param p_B plan for backward transformation
+ * 
+ * Source of the second-order potential \f$ \nabla^2\phi^{(2)} = \sum_{i>j} \phi_{,ii}\phi_{,jj} - \phi_{,ij}^2 \f$
+ * is computed from the six second derivatives of the first-order potential, three at a time.
+ */
+void gen_displ_2LPT(std::vector<Mesh>& vel_field_2, const Mesh& pot_k, const FFTW_PLAN_TYPE &p_F, const FFTW_PLAN_TYPE &p_B)
+{
+    printf("Computing second-order displacement...\n");
+    Mesh& source = vel_field_2[0];
+    const size_t length = source.length;
+
+    // diagonal terms
+    for (size_t i = 0; i < 3; i++) gen_pot_deriv_k(vel_field_2[i], pot_k, i, i);
+    fftw_execute_dft_c2r_triple(p_B, vel_field_2);
+
+    #pragma omp parallel for
+    for (size_t l = 0; l < length; l++)
+    {
+        source[l] = source[l]*vel_field_2[1][l] + source[l]*vel_field_2[2][l] + vel_field_2[1][l]*vel_field_2[2][l];
+    }
+
+    // off-diagonal terms
+    gen_pot_deriv_k(vel_field_2[1], pot_k, 0, 1);
+    gen_pot_deriv_k(vel_field_2[2], pot_k, 0, 2);
+    fftw_execute_dft_c2r(p_B, vel_field_2[1]);
+    fftw_execute_dft_c2r(p_B, vel_field_2[2]);
+
+    #pragma omp parallel for
+    for (size_t l = 0; l < length; l++)
+    {
+        source[l] -= pow2(vel_field_2[1][l]) + pow2(vel_field_2[2][l]);
+    }
+
+    gen_pot_deriv_k(vel_field_2[1], pot_k, 1, 2);
+    fftw_execute_dft_c2r(p_B, vel_field_2[1]);
+
+    #pragma omp parallel for
+    for (size_t l = 0; l < length; l++)
+    {
+        source[l] -= pow2(vel_field_2[1][l]);
+    }
+
+    // second-order potential and displacement, gen_displ_k computes -grad
+    fftw_execute_dft_r2c(p_F, source);
+    gen_pot_k(source);
+    gen_displ_k(vel_field_2, source);
+    fftw_execute_dft_c2r_triple(p_B, vel_field_2);
+    for (Mesh& field : vel_field_2) field *= -1;
+}
+
+/**
+ * @brief fraction of particles which underwent shell-crossing
+ * 
+ * @param particles particles ordered on Lagrangian lattice
+ * @param sim simulation parameters
+ * @return FTYPE_t fraction of particles with negative determinant of \f$ \partial x / \partial q \f$
+ * 
+ * Jacobian of the mapping is estimated by forward differences of positions of neighbouring particles on the lattice.
+ */
+template <class T>
+FTYPE_t get_shell_cross_frac(const std::vector<T>& particles, const Sim_Param &sim)
+{
+    const size_t n = sim.box_opt.par_num_1d;
+    const size_t Np = sim.box_opt.par_num;
+    const size_t Nm = sim.box_opt.mesh_num;
+    const FTYPE_t Ng = sim.box_opt.Ng;
+    size_t crossed = 0;
+    Vec_3D<size_t> q;
+    Vec_3D<FTYPE_t> d[3];
+
+    #pragma omp parallel for private(q, d) reduction(+:crossed)
+    for (size_t i = 0; i < Np; i++)
+    {
+        q[0] = i / (n*n);
+        q[1] = (i / n) % n;
+        q[2] = i % n;
+        const size_t i_nb[3] = {
+            ((q[0] + 1) % n)*n*n + q[1]*n + q[2],
+            q[0]*n*n + ((q[1] + 1) % n)*n + q[2],
+            q[0]*n*n + q[1]*n + (q[2] + 1) % n
+        };
+        for (size_t k = 0; k < 3; k++) d[k] = get_sgn_distance(particles[i_nb[k]].position, particles[i].position, Nm) / Ng;
+        const FTYPE_t det = d[0][0]*(d[1][1]*d[2][2] - d[1][2]*d[2][1])
+                          - d[1][0]*(d[0][1]*d[2][2] - d[0][2]*d[2][1])
+                          + d[2][0]*(d[0][1]*d[1][2] - d[0][2]*d[1][1]);
+        if (det < 0) crossed++;
+    }
+    return FTYPE_t(crossed) / Np;
+}
+
+/**
+ * @brief compute force from current particle positions (particle-mesh)
+ * 
+ * @param particles particles used for density assignment
+ * @param force_field mesh for force, force_field[0] serves as temporary storage for density and potential
+ * @param sim simulation parameters
+ * @param D growth factor, force is divided by it to have the same units as frozen potential force
+ * @param p_F plan for forward transformation
+ * @param p_B plan for backward transformation
+ */
+void get_force_from_par(const std::vector<Particle_v<FTYPE_t>>& particles, std::vector<Mesh>& force_field, const Sim_Param &sim,
+                        const FTYPE_t D, const FFTW_PLAN_TYPE &p_F, const FFTW_PLAN_TYPE &p_B)
+{
+    get_rho_from_par(particles, force_field[0], sim);
+    force_field[0] /= D;
+    fftw_execute_dft_r2c(p_F, force_field[0]);
+    gen_pot_k(force_field[0]);
+    gen_displ_k_cic(force_field, force_field[0]);
+    printf("Computing force in x-space...\n");
+    fftw_execute_dft_c2r_triple(p_B, force_field);
+}
+
 void gen_dens_binned(const Mesh& rho, std::vector<size_t> &dens_binned, const Sim_Param &sim)
 {
 	printf("Computing binned density field...\n");
@@ -643,4 +883,6 @@ void gen_dens_binned(const Mesh& rho, std::vector<size_t> &dens_binned, const Si
 
 template void get_rho_from_par(const std::vector<Particle_x<FTYPE_t>>&, Mesh&, const Sim_Param&);
 template void get_rho_from_par(const std::vector<Particle_v<FTYPE_t>>&, Mesh&, const Sim_Param&);
+template FTYPE_t get_shell_cross_frac(const std::vector<Particle_x<FTYPE_t>>&, const Sim_Param&);
+template FTYPE_t get_shell_cross_frac(const std::vector<Particle_v<FTYPE_t>>&, const Sim_Param&);
 template void gen_pow_spec_binned_from_extrap(const Sim_Param&, const Extrap_Pk<FTYPE_t, 2>&, Data_Vec<FTYPE_t, 2>&);
\ No newline at end of file
@@ -461,6 +461,19 @@ FTYPE_t growth_change(FTYPE_t a, const Cosmo_Param& cosmo)
     }
 }
 
+FTYPE_t growth_factor_2(FTYPE_t a, const Cosmo_Param& cosmo)
+{
+    const FTYPE_t Om = 1 - Omega_lambda(a, cosmo); // flat universe
+    return -3/FTYPE_t(7)*pow2(growth_factor(a, cosmo))*pow(Om, -1/FTYPE_t(143));
+}
+
+FTYPE_t growth_change_2(FTYPE_t a, const Cosmo_Param& cosmo)
+{
+    if (!a) return 0;
+    // d ln(D_2) / d ln(a) = 2f + 3*Omega_L(a)/143, consistent with 'growth_factor_2'
+    return growth_factor_2(a, cosmo)*(2*growth_rate(a, cosmo) + 3*Omega_lambda(a, cosmo)/143)/a;
+}
+
 FTYPE_t Omega_lambda(FTYPE_t a, const Cosmo_Param& cosmo)
 {
     // try ccl range
@@ -18,6 +18,11 @@ void set_unpert_pos(const Sim_Param &sim, std::vector<Particle_x<FTYPE_t>>& part
 void set_unpert_pos_w_vel(const Sim_Param &sim, std::vector<Particle_v<FTYPE_t>>& particles, const std::vector< Mesh> &vel_field);
 void set_pert_pos(const Sim_Param &sim, const FTYPE_t db, std::vector<Particle_x<FTYPE_t>>& particles, const std::vector< Mesh> &vel_field);
 void set_pert_pos(const Sim_Param &sim, const FTYPE_t db, std::vector<Particle_v<FTYPE_t>>& particles, const std::vector< Mesh> &vel_field);
+void set_pert_pos(const Sim_Param &sim, const FTYPE_t a, std::vector<Particle_x<FTYPE_t>>& particles, const std::vector< Mesh> &vel_field,
+                  const std::vector< Mesh> &vel_field_2);
+void set_pert_pos(const Sim_Param &sim, const FTYPE_t a, std::vector<Particle_v<FTYPE_t>>& particles, const std::vector< Mesh> &vel_field,
+                  const std::vector< Mesh> &vel_field_2);
+void get_lagr_displ(const Sim_Param &sim, std::vector<Vec_3D<FTYPE_t>>& displ, const std::vector< Mesh> &vel_field);
 
 void gen_rho_dist_k(const Sim_Param &sim, Mesh& rho, const FFTW_PLAN_TYPE &p_F);
 void gen_pot_k(const Mesh& rho_k, Mesh& pot_k);
@@ -25,9 +30,14 @@ void gen_pot_k(Mesh& rho_k);
 void gen_displ_k(std::vector<Mesh>& vel_field, const Mesh& pot_k);
 void gen_displ_k_cic(std::vector<Mesh>& vel_field, const Mesh& pot_k);
 void gen_displ_k_S2(std::vector<Mesh>& vel_field, const Mesh& pot_k, const FTYPE_t a);
+void gen_displ_2LPT(std::vector<Mesh>& vel_field_2, const Mesh& pot_k, const FFTW_PLAN_TYPE &p_F, const FFTW_PLAN_TYPE &p_B);
+void get_force_from_par(const std::vector<Particle_v<FTYPE_t>>& particles, std::vector<Mesh>& force_field, const Sim_Param &sim,
+                        const FTYPE_t D, const FFTW_PLAN_TYPE &p_F, const FFTW_PLAN_TYPE &p_B);
 
 template <class T>
 void get_rho_from_par(const std::vector<T>& particles, Mesh& rho, const Sim_Param &sim);
+template <class T>
+FTYPE_t get_shell_cross_frac(const std::vector<T>& particles, const Sim_Param &sim);
 bool get_vel_from_par(const std::vector<Particle_v<FTYPE_t>>& particles, std::vector<Mesh>& vel_field, const Sim_Param &sim);
 bool get_vel_from_par(const std::vector<Particle_x<FTYPE_t>>& particles, std::vector<Mesh>& vel_field, const Sim_Param &sim);
 
@@ -60,6 +60,24 @@ FTYPE_t growth_rate(FTYPE_t a, const Cosmo_Param& cosmo);
  */
 FTYPE_t growth_change(FTYPE_t a, const Cosmo_Param& cosmo);
 
+/**
+ * @brief second-order growth factor, \f$ D_2 = -\frac{3}{7}D^2\Omega_m^{-1/143} \f$ (Bouchet et al. 1995)
+ * 
+ * @param a scale factor
+ * @param cosmo cosmological parameters
+ * @return FTYPE_t 
+ */
+FTYPE_t growth_factor_2(FTYPE_t a, const Cosmo_Param& cosmo);
+
+/**
+ * @brief derivative of the second-order growth factor, \f$ \frac{dD_2}{da} = \frac{D_2}{a} \left(2f + \frac{3}{143}\Omega_\Lambda\right) \f$
+ * 
+ * @param a scale factor
+ * @param cosmo cosmological parameters
+ * @return FTYPE_t 
+ */
+FTYPE_t growth_change_2(FTYPE_t a, const Cosmo_Param& cosmo);
+
 /**
  * @brief 
  * 
@@ -8,14 +8,202 @@
 
 #pragma once
 #include "stdafx.h"
-#include <functional>
+#include <type_traits>
 #include "precision.hpp"
 #include "class_mesh.hpp"
 #include "class_particles.hpp"
+#include "core_mesh.h"
+#include "params.hpp"
 
-class Cosmo_Param;
+/**
+ * @brief coefficients of one Stream-Kick-Stream step from 'a - da' to 'a'
+ * @struct Integ_Coeff
+ * 
+ * stream: \f$ x \mathrel{+}= v \cdot stream_i \f$, kick: \f$ v = v \cdot kick_v + F \cdot kick_F \f$
+ * 
+ * By default the factors are evaluated at the middle of the time-step. With 'Integ_Opt::fastpm' the factors
+ * are integrated over the time-step using growth functions (Feng et al. 2016) and linear growth
+ * (Zel`dovich solution) is then reproduced exactly regardless of the size of the time-step.
+ */
+struct Integ_Coeff {
+    Integ_Coeff(const Sim_Param &sim, const FTYPE_t a, const FTYPE_t da);
+    FTYPE_t a_half, da; ///< time of the kick, time-step
+    FTYPE_t stream_1, stream_2; ///< factors of the first and the second stream
+    FTYPE_t kick_v, kick_F; ///< factors of the velocity and the force during kick
+};
+
+/**
+ * @class Kick_No_Momentum
+ * @brief kick of one particle without memory of previous velocity, \f$ v = \frac{dD}{da} u(x) \f$
+ */
+class Kick_No_Momentum
+{
+public:
+    Kick_No_Momentum(const FTYPE_t dDda, const std::vector< Mesh> &vel_field): dDda(dDda), vel_field(vel_field) {}
+
+    void operator()(Particle_v<FTYPE_t>& particle) const
+    {
+        particle.velocity.fill(0.);
+        assign_from(vel_field, particle.position, particle.velocity, dDda);
+    }
+
+private:
+    const FTYPE_t dDda;
+    const std::vector< Mesh> &vel_field;
+};
+
+/**
+ * @class Kick_W_Momentum
+ * @brief kick of one particle by force field, \f$ v = v \cdot kick_v + F \cdot kick_F \f$
+ */
+class Kick_W_Momentum
+{
+public:
+    Kick_W_Momentum(const Integ_Coeff& coeff, const std::vector< Mesh> &force_field):
+        kick_v(coeff.kick_v), kick_F(coeff.kick_F), force_field(force_field) {}
+
+    void operator()(Particle_v<FTYPE_t>& particle) const
+    {
+        Vec_3D<FTYPE_t> force;
+        force.fill(0.);
+        assign_from(force_field, particle.position, force);
+        particle.velocity = particle.velocity*kick_v + force*kick_F;
+    }
+
+private:
+    const FTYPE_t kick_v, kick_F;
+    const std::vector< Mesh> &force_field;
+};
+
+/**
+ * @class Frozen_Force_Kick
+ * @brief kick by force field which does not change during the time-step
+ * 
+ * Kick of each particle depends only on its own position, symplectic integrators therefore
+ * stream, kick, stream and wrap every particle in a single pass (see 'is_local_kick').
+ */
+class Frozen_Force_Kick
+{
+public:
+    Frozen_Force_Kick(const std::vector< Mesh> &force_field): force_field(force_field) {}
+
+    Kick_W_Momentum local(const Integ_Coeff& coeff) const { return Kick_W_Momentum(coeff, force_field); }
+
+private:
+    const std::vector< Mesh> &force_field;
+};
+
+/**
+ * @brief trait for kicks which can be fused with streams, these have to provide 'local(const Integ_Coeff&)'
+ * returning per-particle kick, all other kicks are callable 'void(const Integ_Coeff&)' acting on all particles
+ */
+template<class Kick>
+struct is_local_kick: std::false_type {};
+
+template<>
+struct is_local_kick<Frozen_Force_Kick>: std::true_type {};
 
 void stream_step(const FTYPE_t da, std::vector<Particle_v<FTYPE_t>>& particles);
-void stream_kick_stream(const FTYPE_t da, std::vector<Particle_v<FTYPE_t>>& particles, std::function<void()> kick_step, size_t per);
+
+/**
+ * @brief Stream-Kick-Stream & ensure periodicity in one pass over particles
+ * 
+ * @param kick per-particle kick, callable 'void(Particle_v<FTYPE_t>&)'
+ */
+template<class Kick>
+void stream_kick_stream_fused(const FTYPE_t stream_1, const FTYPE_t stream_2, std::vector<Particle_v<FTYPE_t>>& particles,
+                              const Kick& kick, size_t per)
+{
+    const size_t Np = particles.size();
+    #pragma omp parallel for
+	for (size_t i = 0; i < Np; i++)
+	{
+        Particle_v<FTYPE_t>& particle = particles[i];
+        particle.position += particle.velocity*stream_1;
+        kick(particle);
+        particle.position += particle.velocity*stream_2;
+        get_per(particle.position, per);
+    }
+}
 void kick_step_no_momentum(const Cosmo_Param &cosmo, const FTYPE_t a, std::vector<Particle_v<FTYPE_t>>& particles, const std::vector< Mesh> &vel_field);
-void kick_step_w_momentum(const Cosmo_Param &cosmo, const FTYPE_t a, const FTYPE_t da, std::vector<Particle_v<FTYPE_t>>& particles, const std::vector< Mesh> &force_field);
+void kick_step_w_momentum(const Integ_Coeff& coeff, std::vector<Particle_v<FTYPE_t>>& particles, const std::vector< Mesh> &force_field);
+void runge_kutta_no_momentum(const Cosmo_Param &cosmo, const FTYPE_t a, const FTYPE_t da, std::vector<Particle_v<FTYPE_t>>& particles,
+                             const std::vector< Mesh> &vel_field, size_t per);
+
+/**
+ * @brief symplectic integrator of given order, one time-step from 'a - da' to 'a'
+ * 
+ * @tparam order 2 -- Leapfrog (Stream-Kick-Stream), 4 -- Yoshida (triple jump of Leapfrog steps)
+ * 
+ * 'kick_step' is any callable 'void(const Integ_Coeff&)' passed as template parameter so it can be inlined,
+ * periodicity is ensured after every Leapfrog step. The middle step of Yoshida integrator goes backward in time
+ * (0.35*da before the beginning of the time-step), early time-steps for which it would go below half of the scale factor
+ * at the beginning of the time-step (or reach 'a <= 0') are done by a single Leapfrog step instead.
+ */
+template<unsigned int order>
+struct Symplectic_Integ;
+
+template<>
+struct Symplectic_Integ<2>
+{
+    template<class Kick>
+    static void step(const Sim_Param &sim, const FTYPE_t a, const FTYPE_t da, std::vector<Particle_v<FTYPE_t>>& particles,
+                     Kick& kick_step, size_t per)
+    {// general Leapfrog method with given coefficients: Stream-Kick-Stream & ensure periodicity
+        const Integ_Coeff coeff(sim, a, da);
+        step(coeff, particles, kick_step, per, is_local_kick<Kick>());
+    }
+
+private:
+    template<class Kick>
+    static void step(const Integ_Coeff& coeff, std::vector<Particle_v<FTYPE_t>>& particles, Kick& kick_step, size_t per, std::true_type)
+    {// kick depends only on particle itself, single pass
+        stream_kick_stream_fused(coeff.stream_1, coeff.stream_2, particles, kick_step.local(coeff), per);
+    }
+
+    template<class Kick>
+    static void step(const Integ_Coeff& coeff, std::vector<Particle_v<FTYPE_t>>& particles, Kick& kick_step, size_t per, std::false_type)
+    {// kick needs positions of all particles, separate passes
+        stream_step(coeff.stream_1, particles);
+        kick_step(coeff);
+        stream_step(coeff.stream_2, particles);
+        get_per(particles, per);
+    }
+};
+
+template<>
+struct Symplectic_Integ<4>
+{
+    template<class Kick>
+    static void step(const Sim_Param &sim, const FTYPE_t a, const FTYPE_t da, std::vector<Particle_v<FTYPE_t>>& particles,
+                     Kick& kick_step, size_t per)
+    {// Yoshida (1990) coefficients, w_0 + 2*w_1 = 1
+        const FTYPE_t cbrt_2 = cbrt(FTYPE_t(2));
+        const FTYPE_t w_1 = 1/(2 - cbrt_2);
+        const FTYPE_t w_0 = -cbrt_2/(2 - cbrt_2);
+        const FTYPE_t a_0 = a - da;
+
+        // middle step would go too far back in time, e.g. first time-steps from high redshift
+        if (a_0 + (w_0 + w_1)*da <= a_0/2) return Symplectic_Integ<2>::step(sim, a, da, particles, kick_step, per);
+
+        Symplectic_Integ<2>::step(sim, a_0 + w_1*da, w_1*da, particles, kick_step, per);
+        Symplectic_Integ<2>::step(sim, a_0 + (w_0 + w_1)*da, w_0*da, particles, kick_step, per);
+        Symplectic_Integ<2>::step(sim, a, w_1*da, particles, kick_step, per);
+    }
+};
+
+/**
+ * @brief integrate one time-step from 'a - da' to 'a' with symplectic integrator of order 'Integ_Opt::order'
+ * 
+ * @param kick_step callable 'void(const Integ_Coeff&)'
+ */
+template<class Kick>
+void symplectic_step(const Sim_Param &sim, const FTYPE_t a, const FTYPE_t da, std::vector<Particle_v<FTYPE_t>>& particles,
+                     Kick kick_step, size_t per)
+{
+    switch (sim.integ_opt.order)
+    {
+        case 4: Symplectic_Integ<4>::step(sim, a, da, particles, kick_step, per); break;
+        default: Symplectic_Integ<2>::step(sim, a, da, particles, kick_step, per);
+    }
+}
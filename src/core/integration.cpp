@@ -11,6 +11,73 @@
 #include "integration.hpp"
 #include "params.hpp"
 
+/*****************************//**
+ * PRIVATE FUNCTIONS DEFINITIONS *
+ *********************************/
+namespace{
+
+/**
+ * @brief Hubble parameter normalized to \f$H(a = 1) \equiv 1\f$ (flat LCDM)
+ */
+FTYPE_t hubble_param(const FTYPE_t a, const Cosmo_Param& cosmo)
+{
+    return sqrt(cosmo.Omega_m/pow(a, 3) + cosmo.Omega_L());
+}
+
+/**
+ * @brief growth of momentum \f$ p = a^3 H(a) v \f$ in linear regime, \f$ G_p = a^3 H(a) \frac{dD}{da} \f$
+ */
+FTYPE_t growth_momentum(const FTYPE_t a, const Cosmo_Param& cosmo)
+{
+    return pow(a, 3)*hubble_param(a, cosmo)*growth_change(a, cosmo);
+}
+} ///< end of anonymous namespace (private definitions)
+
+/****************************//**
+ * PUBLIC FUNCTIONS DEFINITIONS *
+ ********************************/
+
+Integ_Coeff::Integ_Coeff(const Sim_Param &sim, const FTYPE_t a, const FTYPE_t da):
+    a_half(a - da/2), da(da)
+{
+    const Cosmo_Param& cosmo = sim.cosmo;
+    if (sim.integ_opt.fastpm)
+    {// factors integrated over the time-step, velocity is defined at the boundaries of the time-step
+        const FTYPE_t a_0 = a - da;
+        const FTYPE_t D_0 = growth_factor(a_0, cosmo);
+        const FTYPE_t D_half = growth_factor(a_half, cosmo);
+        const FTYPE_t D_1 = growth_factor(a, cosmo);
+        const FTYPE_t p_norm_0 = pow(a_0, 3)*hubble_param(a_0, cosmo); // v = p / p_norm
+        const FTYPE_t p_norm_1 = pow(a, 3)*hubble_param(a, cosmo);
+
+        stream_1 = (D_half - D_0)/growth_change(a_0, cosmo);
+        stream_2 = (D_1 - D_half)/growth_change(a, cosmo);
+        kick_v = p_norm_0/p_norm_1;
+        kick_F = (growth_momentum(a, cosmo) - growth_momentum(a_0, cosmo))/p_norm_1;
+    }
+    else
+    {// factors evaluated at the middle of the time-step
+        const FTYPE_t D = growth_factor(a_half, cosmo);
+        const FTYPE_t OL = cosmo.Omega_L()*pow(a_half,3);
+        const FTYPE_t Om = cosmo.Omega_m;
+        // -3/2a represents usual EOM, the rest are LCDM corrections
+        const FTYPE_t f1 = 3/(2*a_half)*(Om+2*OL)/(Om+OL);
+        const FTYPE_t f2 = 3/(2*a_half)*Om/(Om+OL)*D/a_half;
+
+        stream_1 = stream_2 = da/2;
+        if (sim.integ_opt.order == 4)
+        {// time-symmetric (implicit midpoint) kick, needed for higher-order composition
+            kick_v = (1 - f1*da/2)/(1 + f1*da/2);
+            kick_F = f2*da/(1 + f1*da/2);
+        }
+        else
+        {
+            kick_v = 1 - f1*da;
+            kick_F = f2*da;
+        }
+    }
+}
+
 void stream_step(const FTYPE_t da, std::vector<Particle_v<FTYPE_t>>& particles)
 {
     const size_t Np = particles.size();
@@ -21,48 +88,65 @@ void stream_step(const FTYPE_t da, std::vector<Particle_v<FTYPE_t>>& particles)
     }
 }
 
-void stream_kick_stream(const FTYPE_t da, std::vector<Particle_v<FTYPE_t>>& particles, std::function<void()> kick_step, size_t per)
-{// general Leapfrog method: Stream-Kick-Stream & ensure periodicity
-    stream_step(da/2, particles);
-    kick_step();
-    stream_step(da/2, particles);
-    get_per(particles, per);
-}
-
 void kick_step_no_momentum(const Cosmo_Param &cosmo, const FTYPE_t a, std::vector<Particle_v<FTYPE_t>>& particles, const std::vector< Mesh> &vel_field)
 {
     // no memory of previus velocity, 1st order ODE
     const size_t Np = particles.size();
-    Vec_3D<FTYPE_t> vel;
-    const FTYPE_t dDda = growth_change(a, cosmo); // dD / da
+    const Kick_No_Momentum kick(growth_change(a, cosmo), vel_field);
     
-    #pragma omp parallel for private(vel)
+    #pragma omp parallel for
     for (size_t i = 0; i < Np; i++)
 	{
-        vel.fill(0.);
-        assign_from(vel_field, particles[i].position, vel);
-        particles[i].velocity = vel*dDda;
+        kick(particles[i]);
     }
 }
 
-void kick_step_w_momentum(const Cosmo_Param &cosmo, const FTYPE_t a, const FTYPE_t da, std::vector<Particle_v<FTYPE_t>>& particles, const std::vector< Mesh> &force_field)
+void kick_step_w_momentum(const Integ_Coeff& coeff, std::vector<Particle_v<FTYPE_t>>& particles, const std::vector< Mesh> &force_field)
 {
     // classical 2nd order ODE
     const size_t Np = particles.size();
-    Vec_3D<FTYPE_t> force;
-    const FTYPE_t D = growth_factor(a, cosmo);
-    const FTYPE_t OL = cosmo.Omega_L()*pow(a,3);
-    const FTYPE_t Om = cosmo.Omega_m;
-    // -3/2a represents usual EOM, the rest are LCDM corrections
-    const FTYPE_t f1 = 3/(2*a)*(Om+2*OL)/(Om+OL);
-    const FTYPE_t f2 = 3/(2*a)*Om/(Om+OL)*D/a;
+    const Kick_W_Momentum kick(coeff, force_field);
     
-    #pragma omp parallel for private(force)
+    #pragma omp parallel for
     for (size_t i = 0; i < Np; i++)
 	{
-        force.fill(0.);
-        assign_from(force_field, particles[i].position, force);
-        force = force*f2 - particles[i].velocity*f1;		
-        particles[i].velocity += force*da;
+        kick(particles[i]);
     }
-}
\ No newline at end of file
+}
+
+void runge_kutta_no_momentum(const Cosmo_Param &cosmo, const FTYPE_t a, const FTYPE_t da, std::vector<Particle_v<FTYPE_t>>& particles,
+                             const std::vector< Mesh> &vel_field, size_t per)
+{
+    // 4th order Runge-Kutta for streamlines dx/da = dD/da * u(x), velocity field is frozen so each particle is independent
+    // stored velocity need not be the streamline velocity at the current position (initial conditions, hybrid handover),
+    // all stages are interpolated from the velocity field, velocity at the end of the time-step is stored
+    const size_t Np = particles.size();
+    Vec_3D<FTYPE_t> k_1, k_2, k_3, k_4, pos;
+    const FTYPE_t a_half = a - da/2;
+    const FTYPE_t dDda_0 = growth_change(a - da, cosmo);
+    const FTYPE_t dDda_half = growth_change(a_half, cosmo);
+    const FTYPE_t dDda_1 = growth_change(a, cosmo);
+
+    #pragma omp parallel for private(k_1, k_2, k_3, k_4, pos)
+    for (size_t i = 0; i < Np; i++)
+	{
+        k_1.fill(0.);
+        assign_from(vel_field, particles[i].position, k_1, dDda_0);
+        pos = particles[i].position + k_1*(da/2);
+        k_2.fill(0.);
+        assign_from(vel_field, pos, k_2, dDda_half);
+
+        pos = particles[i].position + k_2*(da/2);
+        k_3.fill(0.);
+        assign_from(vel_field, pos, k_3, dDda_half);
+
+        pos = particles[i].position + k_3*da;
+        k_4.fill(0.);
+        assign_from(vel_field, pos, k_4, dDda_1);
+
+        particles[i].position += (k_1 + k_2*2 + k_3*2 + k_4)*(da/6);
+        get_per(particles[i].position, per);
+        particles[i].velocity.fill(0.);
+        assign_from(vel_field, particles[i].position, particles[i].velocity, dDda_1);
+    }
+}
@@ -66,6 +66,9 @@ struct Box_Opt {
 struct Integ_Opt {
     void init();
     FTYPE_t z_in, z_out, db; ///< cmd args
+    bool fastpm; ///< integrate kick & stream factors over time-step
+    bool ic_2lpt; ///< second-order LPT initial conditions
+    unsigned int order; ///< order of the integrator (2 or 4)
     FTYPE_t b_in, b_out; ///< derived parameters
 };
 
@@ -94,11 +97,25 @@ struct Out_Opt {
  */
 struct Comp_App {
     /* cmd args */
-    bool ZA, FF, FP, AA, FP_pp; //< approximations
+    bool ZA, LPT2, FF, FP, AA, FP_pp, COLA, PM; //< approximations
     bool chi; //< modified gravities
 };
 
 
+/**
+ * @brief options of hybrid simulation, i.e. chain of approximations
+ * @struct Hybrid_Opt
+ * 
+ */
+struct Hybrid_Opt {
+    void init(const Integ_Opt& integ_opt);
+    /* cmd args */
+    std::vector<std::string> apps; //< approximations in order of the run (empty = no hybrid simulation)
+    std::vector<FTYPE_t> z_switch; //< redshifts of handover between consecutive approximations
+    FTYPE_t shell_cross; //< handover sooner when fraction of shell-crossed particles exceeds this value (0 = never)
+};
+
+
 /**
  * @brief approximations options
  * @struct App_Opt
@@ -108,6 +125,11 @@ struct App_Opt {
     void init(const Box_Opt&);
     /* cmd args */
     FTYPE_t nu, rs;
+    FTYPE_t skin; ///< skin of Verlet lists in units of mesh cells, zero to search chaining mesh every step
+    bool tree; ///< short range force from octree instead of chaining mesh
+    FTYPE_t theta; ///< opening angle of octree
+    unsigned block_levels; ///< short range force sub-cycled in up to '2^block_levels' sub-steps, zero to disable
+    FTYPE_t block_eta; ///< accuracy parameter of block time-steps
     /* derived param*/
     FTYPE_t Hc, a, nu_dim;
     size_t M;
@@ -175,6 +197,12 @@ struct Other_par {
 struct Chi_Opt {
     /* cmd args */
     FTYPE_t beta, n, phi;
+    bool warm; ///< start solver from the previous solution
+    FTYPE_t linear; ///< use linear solution when max|dchi| is below this value
+    bool newton; ///< solve with Newton-Krylov method instead of nonlinear multigrid
+    bool fd, fd_smooth; ///< force by finite differences instead of FFT, smooth it in transverse directions
+    unsigned resolve_steps; ///< solve the field at least every 'resolve_steps' kicks, 0 for no limit
+    FTYPE_t resolve_res; ///< solve the field again when residual of the last solution exceeds this value, 0 to disable
 };
 
 /**
@@ -193,6 +221,7 @@ public:
     Integ_Opt integ_opt;
     Out_Opt out_opt;
     Comp_App comp_app;
+    Hybrid_Opt hybrid_opt;
     Cosmo_Param cosmo;
     App_Opt app_opt;
     Run_Opt run_opt;
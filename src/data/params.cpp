@@ -147,7 +147,10 @@ void to_json(json& j, const Integ_Opt& integ_opt)
     j = json{
         {"redshift", integ_opt.z_in},
         {"redshift_0", integ_opt.z_out},
-        {"time_step", integ_opt.db}
+        {"time_step", integ_opt.db},
+        {"fastpm", integ_opt.fastpm},
+        {"ic_2lpt", integ_opt.ic_2lpt},
+        {"integ_order", integ_opt.order}
     };
 }
 
@@ -156,6 +159,12 @@ void from_json(const json& j, Integ_Opt& integ_opt)
     integ_opt.z_in = j.at("redshift").get<FTYPE_t>();
     integ_opt.z_out = j.at("redshift_0").get<FTYPE_t>();
     integ_opt.db = j.at("time_step").get<FTYPE_t>();
+    try{ integ_opt.fastpm = j.at("fastpm").get<bool>(); }
+    catch(const std::out_of_range& oor){ integ_opt.fastpm = false; } // older json files
+    try{ integ_opt.ic_2lpt = j.at("ic_2lpt").get<bool>(); }
+    catch(const std::out_of_range& oor){ integ_opt.ic_2lpt = false; } // older json files
+    try{ integ_opt.order = j.at("integ_order").get<unsigned int>(); }
+    catch(const std::out_of_range& oor){ integ_opt.order = 2; } // older json files
 
     integ_opt.init();
 }
@@ -164,7 +173,12 @@ void to_json(json& j, const App_Opt& app_opt)
 {
     j = json{
         {"viscosity", app_opt.nu_dim},
-        {"cut_radius", app_opt.rs}
+        {"cut_radius", app_opt.rs},
+        {"verlet_skin", app_opt.skin},
+        {"tree_pm", app_opt.tree},
+        {"tree_theta", app_opt.theta},
+        {"block_levels", app_opt.block_levels},
+        {"block_eta", app_opt.block_eta}
     };
 }
 
@@ -173,6 +187,16 @@ void from_json(const json& j, App_Opt& app_op)
     app_op.nu_dim = j.at("viscosity").get<FTYPE_t>();
     app_op.nu = app_op.nu_dim;
     app_op.rs = j.at("cut_radius").get<FTYPE_t>();
+    try{ app_op.skin = j.at("verlet_skin").get<FTYPE_t>(); }
+    catch(const std::out_of_range& oor){ app_op.skin = 0; } // older json files
+    try{ app_op.tree = j.at("tree_pm").get<bool>(); }
+    catch(const std::out_of_range& oor){ app_op.tree = false; } // older json files
+    try{ app_op.theta = j.at("tree_theta").get<FTYPE_t>(); }
+    catch(const std::out_of_range& oor){ app_op.theta = 0.5; } // older json files
+    try{ app_op.block_levels = j.at("block_levels").get<unsigned>(); }
+    catch(const std::out_of_range& oor){ app_op.block_levels = 0; } // older json files
+    try{ app_op.block_eta = j.at("block_eta").get<FTYPE_t>(); }
+    catch(const std::out_of_range& oor){ app_op.block_eta = 0.025; } // older json files
 }
 
 void to_json(json& j, const Run_Opt& run_opt)
@@ -211,7 +235,14 @@ void to_json(json& j, const Chi_Opt& chi_opt)
     j = json{
         {"beta", chi_opt.beta},
         {"n", chi_opt.n},
-        {"phi", chi_opt.phi}
+        {"phi", chi_opt.phi},
+        {"warm", chi_opt.warm},
+        {"linear", chi_opt.linear},
+        {"newton", chi_opt.newton},
+        {"fd", chi_opt.fd},
+        {"fd_smooth", chi_opt.fd_smooth},
+        {"resolve_steps", chi_opt.resolve_steps},
+        {"resolve_res", chi_opt.resolve_res}
     };
 }
 
@@ -220,6 +251,20 @@ void from_json(const json& j, Chi_Opt& chi_opt)
     chi_opt.beta = j.at("beta").get<FTYPE_t>();
     chi_opt.n = j.at("n").get<FTYPE_t>();
     chi_opt.phi = j.at("phi").get<FTYPE_t>();
+    try{ chi_opt.warm = j.at("warm").get<bool>(); }
+    catch(const std::out_of_range& oor){ chi_opt.warm = false; }
+    try{ chi_opt.linear = j.at("linear").get<FTYPE_t>(); }
+    catch(const std::out_of_range& oor){ chi_opt.linear = 0; }
+    try{ chi_opt.newton = j.at("newton").get<bool>(); }
+    catch(const std::out_of_range& oor){ chi_opt.newton = false; }
+    try{ chi_opt.fd = j.at("fd").get<bool>(); }
+    catch(const std::out_of_range& oor){ chi_opt.fd = false; }
+    try{ chi_opt.fd_smooth = j.at("fd_smooth").get<bool>(); }
+    catch(const std::out_of_range& oor){ chi_opt.fd_smooth = false; }
+    try{ chi_opt.resolve_steps = j.at("resolve_steps").get<unsigned>(); }
+    catch(const std::out_of_range& oor){ chi_opt.resolve_steps = 1; }
+    try{ chi_opt.resolve_res = j.at("resolve_res").get<FTYPE_t>(); }
+    catch(const std::out_of_range& oor){ chi_opt.resolve_res = 0; }
 }
 
 void to_json(json& j, const Test_Opt& test_opt)
@@ -319,6 +364,26 @@ void Integ_Opt::init()
 {
     b_in = 1/(z_in + 1);
 	b_out = 1/(z_out + 1);
+    if ((order != 2) && (order != 4)){
+        throw std::out_of_range("Invalid order of the integrator (" + std::to_string(order) + "), only 2 and 4 are implemented!");
+    }
+}
+
+void Hybrid_Opt::init(const Integ_Opt& integ_opt)
+{
+    if (apps.empty()) return;
+    if (z_switch.size() + 1 != apps.size()){
+        throw std::out_of_range("Hybrid simulation of " + std::to_string(apps.size()) + " approximations needs "
+                                + std::to_string(apps.size() - 1) + " redshifts of handover, got " + std::to_string(z_switch.size()) + "!");
+    }
+    FTYPE_t z_prev = integ_opt.z_in;
+    for (const FTYPE_t z : z_switch){
+        if ((z >= z_prev) || (z <= integ_opt.z_out)){
+            throw std::out_of_range("Redshifts of handover have to be decreasing within (" + std::to_string(integ_opt.z_out)
+                                    + ", " + std::to_string(integ_opt.z_in) + ")!");
+        }
+        z_prev = z;
+    }
 }
 
 void Out_Opt::init()
@@ -331,7 +396,11 @@ void Out_Opt::init()
 void App_Opt::init(const Box_Opt& box_opt)
 {
     a = rs / FTYPE_t(0.735);
-    M = (int)(box_opt.mesh_num / rs);
+    if ((theta < 0) || (theta >= 1)) throw std::out_of_range("Invalid opening angle of octree, 'tree_theta' = " + std::to_string(theta));
+    if (block_levels > 16) throw std::out_of_range("Invalid number of levels of block time-steps, 'block_levels' = " + std::to_string(block_levels));
+    if (block_eta <= 0) throw std::out_of_range("Invalid accuracy of block time-steps, 'block_eta' = " + std::to_string(block_eta));
+    if (skin < 0) throw std::out_of_range("Invalid skin of Verlet lists, 'verlet_skin' = " + std::to_string(skin));
+    M = (int)(box_opt.mesh_num / (rs + skin)); // chaining cells have to contain neighbours within the skin
     Hc = FTYPE_t(box_opt.mesh_num) / M;
     nu_dim = nu;
     nu /= pow2(box_opt.box_size/box_opt.mesh_num); // converting to dimensionless units
@@ -362,6 +431,7 @@ Sim_Param::Sim_Param(int ac, const char* const av[])
     cosmo.init();
     box_opt.init(cosmo);
     integ_opt.init();
+    hybrid_opt.init(integ_opt);
     out_opt.init();
     app_opt.init(box_opt);
     other_par.init(box_opt);
@@ -430,8 +500,18 @@ void Sim_Param::print_info(std::string out, std::string app) const
         std::cout <<"\t\t[mass_function_method = " << find_value(mass_function_method, cosmo.config.mass_function_method) << "]\n";
         std::cout << "\t\t[baryons_power_spectrum_method = " << find_value(baryons_power_spectrum_method, cosmo.config.baryons_power_spectrum_method) << "]\n";
         printf("AA:\t\t[nu = %G (Mpc/h)^2]\n", app_opt.nu_dim);
-        printf("LL:\t\t[rs = %G, a = %G, M = %i, Hc = %G]\n", app_opt.rs, app_opt.a, app_opt.M, app_opt.Hc);
-        if (comp_app.chi) printf("Chameleon:\t[beta = %.3f, n = %.2f, phi = %G\n", chi_opt.beta, chi_opt.n, chi_opt.phi);
+        printf("LL:\t\t[rs = %G, a = %G, M = %i, Hc = %G, skin = %G]\n", app_opt.rs, app_opt.a, app_opt.M, app_opt.Hc, app_opt.skin);
+        if (app_opt.tree) printf("Tree-PM:\t[theta = %G]\n", app_opt.theta);
+        if (app_opt.block_levels) printf("Block steps:\t[levels = %u, eta = %G]\n", app_opt.block_levels, app_opt.block_eta);
+        if (comp_app.chi) printf("Chameleon:\t[beta = %.3f, n = %.2f, phi = %G, warm = %i, linear = %G, newton = %i, fd = %i, fd_smooth = %i, resolve_steps = %u, resolve_res = %G]\n",
+                                 chi_opt.beta, chi_opt.n, chi_opt.phi, chi_opt.warm, chi_opt.linear, chi_opt.newton, chi_opt.fd, chi_opt.fd_smooth,
+                                 chi_opt.resolve_steps, chi_opt.resolve_res);
+        if (!hybrid_opt.apps.empty())
+        {
+            printf("Hybrid:\t\t[%s", hybrid_opt.apps[0].c_str());
+            for (size_t i = 1; i < hybrid_opt.apps.size(); i++) printf(" -(z = %G)-> %s", hybrid_opt.z_switch[i-1], hybrid_opt.apps[i].c_str());
+            printf("]\n");
+        }
         printf("num_thread:\t%i\n", run_opt.nt);
         printf( "Output:\t\t'%s'\n", out_opt.out_dir.c_str());
     }
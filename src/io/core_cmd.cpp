@@ -11,6 +11,7 @@
 #include <boost/program_options.hpp>
 #include <iomanip>
 #include <fstream>
+#include <sstream>
 #include "params.hpp"
 #include "core_cmd.h"
 
@@ -26,8 +27,8 @@ struct Dvector { std::vector<FTYPE_t> v; };
 void validate(boost::any& v, const std::vector<std::string>& values, Dvector*, int) {
   Dvector dvalues;
   for(auto val : values){
-      std::cout << val;
-      dvalues.v.push_back(stod(val));
+      std::istringstream tokens(val); // config file passes all values in one string
+      for(std::string token; tokens >> token; ) dvalues.v.push_back(stod(token));
   }
   v = dvalues;
 }
@@ -39,7 +40,7 @@ void validate(boost::any& v, const std::vector<std::string>& values, Dvector*, i
 
 void handle_cmd_line(int ac, const char* const av[], Sim_Param& sim){
     std::string config_file;
-    Dvector print_z;
+    Dvector print_z, hybrid_z;
     unsigned int trans_func_cmd, matter_pwr_cmd, baryons_pwr_cmd, mass_func_cmd;
     // options ONLY on command line
     po::options_description generic("Generic options");
@@ -63,6 +64,12 @@ void handle_cmd_line(int ac, const char* const av[], Sim_Param& sim){
         ("redshift,z", po::value<FTYPE_t>(&sim.integ_opt.z_in)->default_value(200.), "redshift at the start of the simulation")
         ("redshift_0,Z", po::value<FTYPE_t>(&sim.integ_opt.z_out)->default_value(10.), "redshift at the end of the simulation")
         ("time_step,a", po::value<FTYPE_t>(&sim.integ_opt.db)->default_value(0.1, "0.1"), "dimensionless time-step (scale factor)")
+        ("fastpm", po::value<bool>(&sim.integ_opt.fastpm)->default_value(false), "integrate kick and stream factors over "
+                                                                            "time-step using growth functions (FastPM)")
+        ("integ_order", po::value<unsigned int>(&sim.integ_opt.order)->default_value(2), "order of the integrator: 2 (Leapfrog), 4 (Yoshida, "
+                                                                            "Runge-Kutta for frozen-flow; Leapfrog for early time-steps "
+                                                                            "whose middle Yoshida step would go below half of the scale factor)")
+        ("ic_2lpt", po::value<bool>(&sim.integ_opt.ic_2lpt)->default_value(false), "second-order Lagrangian perturbation theory initial conditions")
         ;
     
     po::options_description config_output("Output options");
@@ -84,11 +91,23 @@ void handle_cmd_line(int ac, const char* const av[], Sim_Param& sim){
     po::options_description config_app("Approximations");
     config_app.add_options()
         ("comp_ZA", po::value<bool>(&sim.comp_app.ZA)->default_value(false), "compute Zeldovich approximation")
+        ("comp_LPT2", po::value<bool>(&sim.comp_app.LPT2)->default_value(false), "compute second-order Lagrangian perturbation theory")
         ("comp_FF", po::value<bool>(&sim.comp_app.FF)->default_value(false), "compute Frozen-flow approximation")
         ("comp_FP", po::value<bool>(&sim.comp_app.FP)->default_value(false), "compute Frozen-potential approximation")
         ("comp_AA", po::value<bool>(&sim.comp_app.AA)->default_value(false), "compute Adhesion approximation")
         ("comp_FP_pp", po::value<bool>(&sim.comp_app.FP_pp)->default_value(false),
                             "compute Frozen-potential approximation (particle-particle interaction)")
+        ("comp_PM", po::value<bool>(&sim.comp_app.PM)->default_value(false), "compute particle-mesh N-body simulation")
+        ("comp_COLA", po::value<bool>(&sim.comp_app.COLA)->default_value(false), "compute COLA (COmoving Lagrangian Acceleration) method")
+        ;
+        
+    po::options_description config_hybrid("Hybrid simulations");
+    config_hybrid.add_options()
+        ("hybrid", po::value<std::vector<std::string>>(&sim.hybrid_opt.apps)->multitoken(),
+                            "chain of approximations (ZA, LPT2, FF, FP, AA, FP_pp, COLA, PM, chi), particles are handed over between them (optional)")
+        ("hybrid_z", po::value<Dvector>(&hybrid_z)->multitoken(), "redshifts of handover between consecutive approximations")
+        ("hybrid_shell_cross", po::value<FTYPE_t>(&sim.hybrid_opt.shell_cross)->default_value(0., "0"),
+                            "handover sooner when fraction of shell-crossed particles exceeds this value, set 0 to switch at 'hybrid_z' only")
         ;
         
     po::options_description config_power("Cosmological parameters");
@@ -118,6 +137,13 @@ void handle_cmd_line(int ac, const char* const av[], Sim_Param& sim){
     config_other.add_options()
         ("viscosity,v", po::value<FTYPE_t>(&sim.app_opt.nu)->default_value(1., "1.0"), "'viscozity' for adhesion approximation in units of pixel^2")
         ("cut_radius,r", po::value<FTYPE_t>(&sim.app_opt.rs)->default_value(2.7, "2.7"), "short-range force cutoff radius in units of mesh cells")
+        ("verlet_skin", po::value<FTYPE_t>(&sim.app_opt.skin)->default_value(0., "0.0"), "skin of Verlet lists for short-range force "
+                                                                                            "in units of mesh cells, 0 to disable")
+        ("tree_pm", po::value<bool>(&sim.app_opt.tree)->default_value(false), "compute short-range force from octree instead of chaining mesh")
+        ("tree_theta", po::value<FTYPE_t>(&sim.app_opt.theta)->default_value(0.5, "0.5"), "opening angle of octree")
+        ("block_levels", po::value<unsigned>(&sim.app_opt.block_levels)->default_value(0), "sub-cycle short-range force in up to 2^block_levels "
+                                                                                            "block time-steps (second order, Kick-Drift-Kick), 0 to disable")
+        ("block_eta", po::value<FTYPE_t>(&sim.app_opt.block_eta)->default_value(0.025, "0.025"), "accuracy parameter of block time-steps")
         ;
 
     po::options_description mod_grav("Modified Gravities");
@@ -130,6 +156,20 @@ void handle_cmd_line(int ac, const char* const av[], Sim_Param& sim){
         ("chi_beta", po::value<FTYPE_t>(&sim.chi_opt.beta)->default_value(1/sqrt(6), "(1/6)^1/2"), "coupling constant")
         ("chi_n", po::value<FTYPE_t>(&sim.chi_opt.n)->default_value(0.5, "1/2"), "chameleon power-law potential exponent,\n0 < n < 1")
         ("chi_phi", po::value<FTYPE_t>(&sim.chi_opt.phi)->default_value(1E-6, "1E-6"), "screening potential")
+        ("chi_warm", po::value<bool>(&sim.chi_opt.warm)->default_value(false), "start chameleon solver from the previous solution")
+        ("chi_linear", po::value<FTYPE_t>(&sim.chi_opt.linear)->default_value(0), "use linear chameleon field when max|dchi| of linear solution "
+                                                                                 "is below this value, 0 to always solve nonlinear equations")
+        ("chi_newton", po::value<bool>(&sim.chi_opt.newton)->default_value(false), "solve chameleon equation with Newton-Krylov method "
+                                                                                  "instead of nonlinear multigrid")
+        ("chi_fd", po::value<bool>(&sim.chi_opt.fd)->default_value(false), "compute chameleon force by finite differences instead of FFT")
+        ("chi_fd_smooth", po::value<bool>(&sim.chi_opt.fd_smooth)->default_value(false), "smooth finite-difference chameleon force by "
+                                                                                        "[1,2,1] kernel in transverse directions")
+        ("chi_resolve_steps", po::value<unsigned>(&sim.chi_opt.resolve_steps)->default_value(1), "solve chameleon field at least every "
+                                                                                                "'chi_resolve_steps' kicks, 1 to solve every kick, 0 for no limit "
+                                                                                                "(requires 'chi_resolve_res')")
+        ("chi_resolve_res", po::value<FTYPE_t>(&sim.chi_opt.resolve_res)->default_value(0), "solve chameleon field again when residual of "
+                                                                                           "the last solution exceeds this value, 0 to disable, "
+                                                                                           "ignored when 'chi_resolve_steps' = 1")
         ;  
     mod_grav.add(config_cham);
     
@@ -149,7 +189,7 @@ void handle_cmd_line(int ac, const char* const av[], Sim_Param& sim){
 
     po::options_description cmdline_options("\nCOSMOLOGICAL APPROXIMATION");//< store all normal parameters
     cmdline_options.add(generic).add(config_mesh).add(config_power).add(config_integ);
-    cmdline_options.add(config_output).add(config_app).add(config_run).add(config_other);
+    cmdline_options.add(config_output).add(config_app).add(config_hybrid).add(config_run).add(config_other);
     cmdline_options.add(mod_grav);
 
     config_test.add(cmdline_options);//< union of test parameters and normaln ones
@@ -180,6 +220,7 @@ void handle_cmd_line(int ac, const char* const av[], Sim_Param& sim){
     // !!!>>> THIS NEEDS TO BE AFTER ALL CALLS TO NOTIFY() <<<!!!
 
     sim.out_opt.print_z = print_z.v;
+    sim.hybrid_opt.z_switch = hybrid_z.v;
     sim.cosmo.config.transfer_function_method = static_cast<transfer_function_t>(trans_func_cmd);
     sim.cosmo.config.matter_power_spectrum_method = static_cast<matter_power_spectrum_t>(matter_pwr_cmd);
     sim.cosmo.config.baryons_power_spectrum_method = static_cast<baryons_power_spectrum_t>(baryons_pwr_cmd);
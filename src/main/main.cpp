@@ -12,9 +12,13 @@
 #include "params.hpp"
 #include "adhesion.hpp"
 #include "chameleon.hpp"
+#include "cola.hpp"
 #include "frozen_flow.hpp"
 #include "frozen_potential.hpp"
+#include "hybrid.hpp"
 #include "mod_frozen_potential.hpp"
+#include "particle_mesh.hpp"
+#include "second_order_lpt.hpp"
 #include "zeldovich.hpp"
 
 template<class T>
@@ -48,6 +52,9 @@ int main(int argc, char* argv[]){
         do{
             /* ZEL`DOVICH APPROXIMATION */
             if(sim.comp_app.ZA)	init_and_run_app<App_Var_ZA>(sim);
+
+            /* SECOND-ORDER LAGRANGIAN PERTURBATION THEORY */
+            if(sim.comp_app.LPT2)	init_and_run_app<App_Var_LPT2>(sim);
             
             /* FROZEN-FLOW APPROXIMATION */
             if(sim.comp_app.FF)	init_and_run_app<App_Var_FF>(sim);
@@ -61,9 +68,18 @@ int main(int argc, char* argv[]){
             /* MODIFIED FROZEN-POTENTIAL APPROXIMATION */
             if(sim.comp_app.FP_pp)	init_and_run_app<App_Var_FP_mod>(sim);
 
+            /* PARTICLE-MESH N-BODY SIMULATION */
+            if(sim.comp_app.PM)	init_and_run_app<App_Var_PM>(sim);
+
+            /* COMOVING LAGRANGIAN ACCELERATION */
+            if(sim.comp_app.COLA)	init_and_run_app<App_Var_COLA>(sim);
+
             /* CHAMELEON GRAVITY (FROZEN-POTENTIAL APPROXIMATION) */
             if(sim.comp_app.chi) init_and_run_app<App_Var_Chi>(sim);
 
+            /* HYBRID SIMULATION */
+            if(!sim.hybrid_opt.apps.empty()) run_hybrid(sim);
+
         } while (sim.simulate());
 
         clock_gettime(CLOCK_MONOTONIC, &finish);
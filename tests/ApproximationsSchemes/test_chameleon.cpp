@@ -1,6 +1,7 @@
 #include <catch.hpp>
 #include "../test.hpp"
 #include "chameleon.cpp"
+#include <numeric>
 
 namespace{
 
@@ -186,6 +187,9 @@ TEST_CASE( "UNIT TEST: create and initialize ChiSolver, check bulk field", "[cha
         const FTYPE_t chi_bulk = sol.chi_min(rho_0);
         FTYPE_t const* const chi = sol.get_y();
         for(size_t i : some_indices) REQUIRE( chi[i] == Approx(chi_bulk));
+
+        // uniform field deviates from its value at mean density everywhere the same
+        CHECK( sol.get_nonlinearity() == Approx(std::abs(chi_bulk - 1 - CHI_MIN)) );
     }
 
     // check that EOM is satisfied
@@ -210,9 +214,6 @@ TEST_CASE( "UNIT TEST: create and initialize ChiSolver, solve sphere", "[chamele
     const size_t N_min = sim.test_opt.N_min;
     const bool verbose = sim.test_opt.verbose;
 
-    // initialize ChiSolver
-    ChiSolver<CHI_PREC_t> sol(N, N_min, sim, verbose);
-
     // initialize overdensity -- constant density in sphere of radius R, center at x0, y0, z0
     MultiGrid<3, CHI_PREC_t> rho_grid(N);
     Mesh rho(N);
@@ -226,57 +227,319 @@ TEST_CASE( "UNIT TEST: create and initialize ChiSolver, solve sphere", "[chamele
     const FFTW_PLAN_TYPE p_F = FFTW_PLAN_R2C(N, N, N, rho.real(), rho.complex(), FFTW_ESTIMATE);
     const FFTW_PLAN_TYPE p_B = FFTW_PLAN_C2R(N, N, N, rho.complex(), rho.real(), FFTW_ESTIMATE);
 
-    // set ChiSolver
-    sol.set_time(1, sim.cosmo);
-    sol.set_def_convergence();
-    sol.add_external_grid(&rho_grid);
-    sol.set_ngs_sweeps(sim.test_opt.fine_sweeps, sim.test_opt.coarse_sweeps); //< fine, coarse
+    {// ChiSolver owns FFTW plans of the linear guess, destroy it before FFTW cleanup
+        // initialize ChiSolver
+        ChiSolver<CHI_PREC_t> sol(N, N_min, sim, verbose);
 
-    // compute gravitational potential
-    Mesh phi_pot(rho); //< copy density
-    get_grav_pot(phi_pot, p_F, p_B, sim.box_opt.box_size, sol.get_phi_prefactor());
+        // set ChiSolver
+        sol.set_time(1, sim.cosmo);
+        sol.set_def_convergence();
+        sol.add_external_grid(&rho_grid);
+        sol.set_ngs_sweeps(sim.test_opt.fine_sweeps, sim.test_opt.coarse_sweeps); //< fine, coarse
 
-    // get linear prediction
-    sol.set_linear(rho, p_F, p_B);
-    sol.set_screened();
+        // compute gravitational potential
+        Mesh phi_pot(rho); //< copy density
+        get_grav_pot(phi_pot, p_F, p_B, sim.box_opt.box_size, sol.get_phi_prefactor());
 
-    // full solution on Mesh
-    Mesh chi_full(N);
+        // get linear prediction
+        sol.set_linear(rho, p_F, p_B);
+        sol.set_screened();
 
-    // create directory structure
-    std::string out_dir = sim.out_opt.out_dir + "test_ChiSolver/";
-    remove_all_files(out_dir);
-    create_dir(out_dir);
-    sim.print_info(out_dir, "test");
+        // full solution on Mesh
+        Mesh chi_full(N);
 
-    // print gravitational potential
-    print_mesh(out_dir + "grav_pot.dat", phi_pot, 0);
+        // create directory structure
+        std::string out_dir = sim.out_opt.out_dir + "test_ChiSolver/";
+        remove_all_files(out_dir);
+        create_dir(out_dir);
+        sim.print_info(out_dir, "test");
 
-    // Solve the equation -- full V-cycles
-    std::cout << "Starting V-cycles with intermediate output...\n";
+        // print gravitational potential
+        print_mesh(out_dir + "grav_pot.dat", phi_pot, 0);
+
+        // Solve the equation -- full V-cycles
+        std::cout << "Starting V-cycles with intermediate output...\n";
     
-    int istep = 0;
-    const size_t step_per_iter = sim.test_opt.step_per_iter;
-    while(1)
-    {
-        // istep, max_step (use int for the last iteration -- negative max_step)
-        istep += sol.get_istep();
-        int max_step = istep + step_per_iter > sim.test_opt.max_steps ? sim.test_opt.max_steps - istep : step_per_iter;
+        int istep = 0;
+        const size_t step_per_iter = sim.test_opt.step_per_iter;
+        while(1)
+        {
+            // istep, max_step (use int for the last iteration -- negative max_step)
+            istep += sol.get_istep();
+            int max_step = istep + step_per_iter > sim.test_opt.max_steps ? sim.test_opt.max_steps - istep : step_per_iter;
 
-        // print chi_full
-        transform_MultiGridSolver_to_Mesh(chi_full, sol);
-        print_mesh(out_dir + "chi_istep_" + std::to_string(istep) + ".dat", chi_full);
+            // print chi_full
+            transform_MultiGridSolver_to_Mesh(chi_full, sol);
+            print_mesh(out_dir + "chi_istep_" + std::to_string(istep) + ".dat", chi_full);
 
-        // check max_step and convergence
-        if ((max_step <= 0) || ((istep != 0) && (sol.get_istep() < step_per_iter))) break;
+            // check max_step and convergence
+            if ((max_step <= 0) || ((istep != 0) && (sol.get_istep() < step_per_iter))) break;
 
-        // set & solve
-        sol.set_maxsteps(max_step);
-        sol.solve();
+            // set & solve
+            sol.set_maxsteps(max_step);
+            sol.solve();
+        }
     }
 
     // FFTW CLEANUP
 	FFTW_DEST_PLAN(p_F);
     FFTW_DEST_PLAN(p_B);
 	FFTW_PLAN_OMP_CLEAN();
-}
\ No newline at end of file
+}
+
+TEST_CASE( "UNIT TEST: warm start of ChiSolver keeps screened regions {set_screened_warm}", "[chameleon]" )
+{
+    print_unit_msg("warm start of ChiSolver keeps screened regions {set_screened_warm}");
+
+    // initialize Sim_Param
+    const char* const argv[1] = {"test"};
+    Sim_Param sim(1, argv);
+    const size_t N = sim.test_opt.N_grid;
+    const size_t N_min = sim.test_opt.N_min;
+
+    // initialize ChiSolver and overdensity
+    ChiSolver<CHI_PREC_t> sol(N, N_min, sim, false);
+    MultiGrid<3, CHI_PREC_t> rho_grid(N);
+    Mesh rho(N);
+    init_overdensity(sim, rho, rho_grid);
+    Mesh rho_copy(rho);
+
+    // FFTW preparation
+    const FFTW_PLAN_TYPE p_F = FFTW_PLAN_R2C(N, N, N, rho.real(), rho.complex(), FFTW_ESTIMATE);
+    const FFTW_PLAN_TYPE p_B = FFTW_PLAN_C2R(N, N, N, rho.complex(), rho.real(), FFTW_ESTIMATE);
+
+    // cold start
+    sol.set_time(1, sim.cosmo);
+    sol.add_external_grid(&rho_grid);
+    sol.set_linear(rho, p_F, p_B);
+    sol.set_screened();
+    const auto active_set = sol.active_set;
+    REQUIRE( !active_set[0].fix_idx.empty() );
+
+    // new screened point away from the fixed ones, local maximum of density where the guess is at its bulk value
+    const auto& fix_0 = active_set[0].fix_idx;
+    std::vector<size_t> index_list;
+    size_t i_new = 0;
+    for (size_t i = 0; i < sol.get_Ntot(); ++i)
+    {
+        if (sol.get_external_field(0, 0)[i] == MARK_CHI_BOUND_COND) continue;
+        sol.get_neighbor_gridindex(index_list, i, N);
+        if (std::none_of(index_list.begin(), index_list.end(), [&](size_t j){ return std::binary_search(fix_0.begin(), fix_0.end(), j); }))
+        {
+            i_new = i;
+            break;
+        }
+    }
+    rho_copy[(i_new / N)*(N + 2) + i_new % N] = 1E3;
+    sol.get_y(0)[i_new] = sol.chi_min(1E3);
+
+    // warm start with the same density elsewhere, screened regions are kept
+    transform_Mesh_to_MultiGrid(rho_copy, rho_grid);
+    sol.set_screened_warm();
+    CHECK( std::binary_search(sol.active_set[0].fix_idx.begin(), sol.active_set[0].fix_idx.end(), i_new) );
+    for (size_t k = 0; k < fix_0.size(); ++k)
+    {
+        REQUIRE( std::binary_search(sol.active_set[0].fix_idx.begin(), sol.active_set[0].fix_idx.end(), fix_0[k]) );
+        CHECK( sol.get_y(0)[fix_0[k]] == Approx(active_set[0].fix_val[k]) );
+    }
+    for (size_t level = 0; level < sol.get_Nlevel(); ++level)
+    {
+        const auto& as = sol.active_set[level];
+        for (size_t i : as.fix_idx) CHECK( sol.get_external_field(level, 0)[i] == MARK_CHI_BOUND_COND );
+
+        // active and fixed points cover the whole level
+        CHECK( std::accumulate(as.row_num_active.begin(), as.row_num_active.end(), size_t(0)) + as.fix_idx.size() == sol.get_Ntot(level) );
+    }
+
+    // FFTW CLEANUP
+    FFTW_DEST_PLAN(p_F);
+    FFTW_DEST_PLAN(p_B);
+}
+
+TEST_CASE( "UNIT TEST: red-black nonlinear Gauss-Seidel of ChiSolver {ngs_sweep_rb}", "[chameleon]" )
+{
+    print_unit_msg("red-black nonlinear Gauss-Seidel of ChiSolver {ngs_sweep_rb}");
+
+    constexpr size_t N = 16;
+    const char* const argv[1] = {"test"};
+    Sim_Param sim(1, argv);
+    ChiSolver<CHI_PREC_t> sol(N, sim, false);
+
+    // random overdensity and field around its bulk value
+    srand(time(0));
+    MultiGrid<3, CHI_PREC_t> rho_grid(N);
+    for (size_t i = 0; i < rho_grid.get_Ntot(); ++i) rho_grid[0][i] = 2.0*rand()/RAND_MAX - 0.9;
+    sol.set_time(1, sim.cosmo);
+    sol.set_def_convergence();
+    sol.add_external_grid(&rho_grid);
+    sol.set_bulk_field();
+
+    // arithmetic stencil agrees with neighbours from index list
+    std::vector<size_t> index_list;
+    const CHI_PREC_t h = 1.0/CHI_PREC_t(N);
+    for (size_t i = 0; i < rho_grid.get_Ntot(); ++i)
+    {
+        get_neighbor_gridindex(index_list, i, N);
+        CHECK( sol.l_point(sol.get_y()[i], sol.get_stencil(0, i, true)) == Approx(sol.l_operator(0, index_list, true, h)) );
+    }
+
+    // sweeps smooth the residual
+    const double res_0 = sol.rms_residual(0);
+    for (size_t j = 0; j < 10; ++j) sol.ngs_sweep_rb(0);
+    CHECK( sol.rms_residual(0) < 0.1*res_0 );
+}
+
+TEST_CASE( "UNIT TEST: Newton-Krylov solver of ChiSolver {solve_newton}", "[chameleon]" )
+{
+    print_unit_msg("Newton-Krylov solver of ChiSolver {solve_newton}");
+
+    constexpr size_t N = 16;
+    const char* const argv[1] = {"test"};
+    Sim_Param sim(1, argv);
+    ChiSolver<CHI_PREC_t> sol(N, sim, false);
+
+    // random overdensity, field starts at its bulk value
+    srand(time(0));
+    MultiGrid<3, CHI_PREC_t> rho_grid(N);
+    for (size_t i = 0; i < rho_grid.get_Ntot(); ++i) rho_grid[0][i] = 2.0*rand()/RAND_MAX - 0.9;
+    sol.set_time(1, sim.cosmo);
+    sol.set_def_convergence();
+    sol.set_bisection_convergence(CONVERGENCE_BI_STEPS_INIT, CONVERGENCE_BI_DCHI, CONVERGENCE_BI_L);
+    sol.add_external_grid(&rho_grid);
+    sol.set_bulk_field();
+
+    // single-precision solver reaches the tolerance only after refinement in double, as in 'App_Var_Chi'
+    const double res_0 = sol.rms_residual(0);
+    REQUIRE( sol.solve_newton() == ES::SUCCESS );
+    if (CHI_REFINE) REQUIRE( sol.refine() == ES::SUCCESS );
+    CHECK( (CHI_REFINE ? sol.rms_residual(0, sol.chi_hi.data()) : sol.rms_residual(0)) <= CONVERGENCE_NEWTON_RES*res_0 );
+
+    // solution is a fixed point of Gauss-Seidel sweeps
+    const std::vector<CHI_PREC_t> chi(sol.get_y(), sol.get_y() + sol.get_Ntot());
+    sol.ngs_sweep_rb(0);
+    for (size_t i = 0; i < chi.size(); ++i) CHECK( sol.get_y()[i] == Approx(chi[i]).margin(1E-6) );
+}
+
+TEST_CASE( "UNIT TEST: reuse of the last solution for new density {rms_residual_active, keep_solution}", "[chameleon]" )
+{
+    print_unit_msg("reuse of the last solution for new density {rms_residual_active, keep_solution}");
+
+    constexpr size_t N = 16;
+    constexpr FTYPE_t resolve_res = 1E-3;
+    const char* const argv[1] = {"test"};
+    Sim_Param sim(1, argv);
+    ChiSolver<CHI_PREC_t> sol(N, sim, false);
+
+    // random overdensity with dense points fixed at their bulk value
+    srand(time(0));
+    MultiGrid<3, CHI_PREC_t> rho_grid(N);
+    std::vector<size_t> fix_idx;
+    for (size_t i = 0; i < rho_grid.get_Ntot(); ++i)
+    {
+        rho_grid[0][i] = (i % 50) ? 2.0*rand()/RAND_MAX - 0.9 : 1E2;
+        if (!(i % 50)) fix_idx.push_back(i);
+    }
+    const std::vector<CHI_PREC_t> rho(rho_grid[0].get_vec());
+    sol.set_time(1, sim.cosmo);
+    sol.set_def_convergence();
+    sol.add_external_grid(&rho_grid);
+    sol.set_bulk_field();
+    sol.set_active(0, fix_idx);
+    REQUIRE( sol.solve_newton() == ES::SUCCESS );
+    const double res_sol = sol.rms_residual(0);
+
+    // density deposited again is not marked, fixed points are skipped anyway
+    rho_grid[0].get_vec() = rho;
+    CHECK( sol.rms_residual(0) > 1E3*res_sol );
+    CHECK( sol.rms_residual_active() == Approx(res_sol) );
+    CHECK( keep_solution(sol.rms_residual_active()/sol.get_chi_prefactor(), resolve_res, 0, 0) );
+
+    // perturbed density needs new solution
+    for (size_t i = 0; i < rho.size(); ++i) rho_grid[0][i] = rho[i]*CHI_PREC_t(1.05);
+    CHECK_FALSE( keep_solution(sol.rms_residual_active()/sol.get_chi_prefactor(), resolve_res, 0, 0) );
+
+    // limit on the number of kicks
+    CHECK( keep_solution(0, 0, 3, 1) );
+    CHECK_FALSE( keep_solution(0, 0, 3, 2) );
+}
+
+TEST_CASE( "UNIT TEST: single-precision ChiSolver refined in double precision {refine}", "[chameleon]" )
+{
+    print_unit_msg("single-precision ChiSolver refined in double precision {refine}");
+
+    constexpr size_t N = 16;
+    const char* const argv[1] = {"test"};
+    Sim_Param sim(1, argv);
+    ChiSolver<float> sol_f(N, sim, false);
+    ChiSolver<double> sol_d(N, sim, false);
+
+    // the same random overdensity for both solvers, field starts at its bulk value
+    srand(time(0));
+    MultiGrid<3, float> rho_f(N);
+    MultiGrid<3, double> rho_d(N);
+    for (size_t i = 0; i < rho_f.get_Ntot(); ++i) rho_d[0][i] = rho_f[0][i] = 2.0*rand()/RAND_MAX - 0.9;
+    sol_f.set_time(1, sim.cosmo);
+    sol_f.set_def_convergence();
+    sol_f.add_external_grid(&rho_f);
+    sol_f.set_bulk_field();
+    sol_d.set_time(1, sim.cosmo);
+    sol_d.set_def_convergence();
+    sol_d.add_external_grid(&rho_d);
+    sol_d.set_bulk_field();
+
+    // single precision stops above the tolerance, refinement converges to it
+    const double res_0 = sol_f.rms_residual(0);
+    REQUIRE( sol_f.solve_newton() == ChiSolver<float>::ES::SUCCESS );
+    CHECK( sol_f.rms_residual(0) > CONVERGENCE_NEWTON_RES*res_0 );
+    REQUIRE( sol_f.refine() == ChiSolver<float>::ES::SUCCESS );
+    CHECK( sol_f.rms_residual(0, sol_f.chi_hi.data()) <= CONVERGENCE_NEWTON_RES*res_0 );
+
+    // rounded solution agrees with the double-precision one
+    REQUIRE( sol_d.solve_newton() == ChiSolver<double>::ES::SUCCESS );
+    for (size_t i = 0; i < sol_f.get_Ntot(); ++i) CHECK( sol_f.get_y()[i] == Approx(sol_d.get_y()[i]).margin(1E-6) );
+}
+
+TEST_CASE( "UNIT TEST: finite-difference force from Grid {get_force_fd, smooth_121}", "[chameleon]" )
+{
+    print_unit_msg("finite-difference force from Grid {get_force_fd, smooth_121}");
+
+    constexpr size_t N = 32;
+    const FTYPE_t k = 2*PI/N;
+    Grid<3, CHI_PREC_t> chi(N);
+    std::vector<Mesh> force;
+    for (size_t j = 0; j < 3; j++) force.emplace_back(N);
+
+    // plane wave along each axis of Mesh, force is '-grad(chi)'
+    for (size_t axis = 0; axis < 3; axis++)
+    {
+        Mesh chi_mesh(N);
+        for (size_t ix = 0; ix < N; ++ix) for (size_t iy = 0; iy < N; ++iy) for (size_t iz = 0; iz < N; ++iz)
+        {
+            const size_t x[3] = {ix, iy, iz};
+            chi_mesh(ix, iy, iz) = sin(k*x[axis]);
+        }
+        transform_Mesh_to_Grid(chi_mesh, chi);
+        get_force_fd(chi, force);
+
+        for (size_t ix = 0; ix < N; ix += 5) for (size_t iy = 0; iy < N; iy += 3) for (size_t iz = 0; iz < N; iz += 7)
+        {
+            const size_t x[3] = {ix, iy, iz};
+            for (size_t j = 0; j < 3; j++)
+            {
+                const FTYPE_t expected = j == axis ? -k*cos(k*x[axis]) : 0;
+                CHECK( force[j](ix, iy, iz) == Approx(expected).margin(1E-4) );
+            }
+        }
+
+        // smoothing along the wave damps it by 'cos^2(k/2)', across it keeps it
+        Mesh smoothed(chi_mesh);
+        smooth_121(smoothed, axis);
+        smooth_121(chi_mesh, (axis + 1) % 3);
+        for (size_t i = 0; i < N; ++i)
+        {
+            const size_t x[3] = {i, (2*i) % N, (3*i) % N};
+            CHECK( smoothed(x[0], x[1], x[2]) == Approx(pow2(cos(k/2))*sin(k*x[axis])).margin(1E-6) );
+            CHECK( chi_mesh(x[0], x[1], x[2]) == Approx(sin(k*x[axis])).margin(1E-6) );
+        }
+    }
+}
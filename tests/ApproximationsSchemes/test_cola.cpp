@@ -0,0 +1,87 @@
+#include <catch.hpp>
+#include "../test.hpp"
+#include "cola.cpp" ///< implementation testing
+
+TEST_CASE( "UNIT TEST: stream and kick in frame comoving with LPT {stream_step_cola, kick_step_cola}", "[cola]" )
+{
+    print_unit_msg("stream and kick in frame comoving with LPT {stream_step_cola, kick_step_cola}");
+
+    int argc = 1;
+    const char* const argv[1] = {"test"};
+    Sim_Param sim(argc, argv);
+
+    // uniform displacement field and force in linear regime, Zel`dovich solution is exact for any time-step
+    const size_t N = 8;
+    const FTYPE_t u = 0.1;
+    const FTYPE_t x_c = N/2.;
+    std::vector<Mesh> force_field;
+    for(size_t i = 0; i < 3; i++){
+        force_field.emplace_back(N);
+        force_field[i].assign(i ? 0 : u);
+    }
+    const std::vector<Vec_3D<FTYPE_t>> displ(1, Vec_3D<FTYPE_t>(u, FTYPE_t(0), FTYPE_t(0)));
+    const std::vector<Vec_3D<FTYPE_t>> displ_2; // first-order frame
+
+    const FTYPE_t a_0 = 0.1, da = 0.5, a_1 = a_0 + da;
+    const LPT_Growth g_0(a_0, sim.cosmo), g_1(a_1, sim.cosmo);
+
+    for (bool fastpm : {false, true})
+    {
+        sim.integ_opt.fastpm = fastpm;
+        const Integ_Coeff coeff(sim, a_1, da);
+        const LPT_Growth g_half(coeff.a_half, sim.cosmo);
+
+        std::vector<Particle_v<FTYPE_t>> particles(1);
+        particles[0].position = Vec_3D<FTYPE_t>(x_c + g_0.D*u, x_c, x_c);
+        particles[0].velocity = Vec_3D<FTYPE_t>(g_0.dDda*u, FTYPE_t(0), FTYPE_t(0));
+
+        stream_step_cola(coeff.stream_1, g_0, g_half, g_0, particles, displ, displ_2);
+        CHECK( particles[0].position[0] == Approx(x_c + g_half.D*u) );
+
+        kick_step_cola(coeff, g_0, g_half, g_1, particles, force_field, displ, displ_2);
+        CHECK( particles[0].velocity[0] == Approx(g_1.dDda*u) );
+
+        stream_step_cola(coeff.stream_2, g_half, g_1, g_1, particles, displ, displ_2);
+        CHECK( particles[0].position[0] == Approx(x_c + g_1.D*u) );
+        CHECK( particles[0].position[1] == Approx(x_c) );
+        CHECK( particles[0].velocity[1] == Approx(0) );
+    }
+}
+
+TEST_CASE( "UNIT TEST: stream and kick in frame comoving with 2LPT {stream_step_cola, kick_step_cola}", "[cola]" )
+{
+    print_unit_msg("stream and kick in frame comoving with 2LPT {stream_step_cola, kick_step_cola}");
+
+    int argc = 1;
+    const char* const argv[1] = {"test"};
+    Sim_Param sim(argc, argv);
+    sim.integ_opt.fastpm = false;
+
+    // uniform displacement fields and force following 2LPT trajectory
+    const size_t N = 8;
+    const FTYPE_t u = 0.1, u_2 = 0.05;
+    const FTYPE_t x_c = N/2.;
+    const std::vector<Vec_3D<FTYPE_t>> displ(1, Vec_3D<FTYPE_t>(u, FTYPE_t(0), FTYPE_t(0)));
+    const std::vector<Vec_3D<FTYPE_t>> displ_2(1, Vec_3D<FTYPE_t>(u_2, FTYPE_t(0), FTYPE_t(0)));
+
+    const FTYPE_t a_0 = 0.1, da = 0.5, a_1 = a_0 + da;
+    const Integ_Coeff coeff(sim, a_1, da);
+    const LPT_Growth g_0(a_0, sim.cosmo), g_half(coeff.a_half, sim.cosmo), g_1(a_1, sim.cosmo);
+
+    std::vector<Mesh> force_field;
+    for(size_t i = 0; i < 3; i++){
+        force_field.emplace_back(N);
+        force_field[i].assign(i ? 0 : u + (g_half.D_2 - pow2(g_half.D))/g_half.D*u_2);
+    }
+
+    std::vector<Particle_v<FTYPE_t>> particles(1);
+    particles[0].position = Vec_3D<FTYPE_t>(x_c + g_0.D*u + g_0.D_2*u_2, x_c, x_c);
+    particles[0].velocity = Vec_3D<FTYPE_t>(g_0.dDda*u + g_0.dD2da*u_2, FTYPE_t(0), FTYPE_t(0));
+
+    stream_step_cola(coeff.stream_1, g_0, g_half, g_0, particles, displ, displ_2);
+    kick_step_cola(coeff, g_0, g_half, g_1, particles, force_field, displ, displ_2);
+    stream_step_cola(coeff.stream_2, g_half, g_1, g_1, particles, displ, displ_2);
+
+    CHECK( particles[0].position[0] == Approx(x_c + g_1.D*u + g_1.D_2*u_2) );
+    CHECK( particles[0].velocity[0] == Approx(g_1.dDda*u + g_1.dD2da*u_2) );
+}
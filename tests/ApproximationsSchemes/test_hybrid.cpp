@@ -0,0 +1,50 @@
+#include <catch.hpp>
+#include "../test.hpp"
+#include "hybrid.cpp" ///< implementation testing
+#include "core_mesh.h"
+
+TEST_CASE( "UNIT TEST: handover of particles between stages of hybrid simulation {run_stage, run_hybrid}", "[hybrid]" )
+{
+    print_unit_msg("handover of particles between stages of hybrid simulation {run_stage, run_hybrid}");
+
+    // small box without any output
+    int argc = 17;
+    const char* const argv[17] = {"test", "--mesh_num", "16", "--mesh_num_pwr", "16", "--par_num", "8", "--box_size", "100",
+                                  "--redshift", "50", "--redshift_0", "5", "--time_step", "0.05", "--print_every", "0"};
+    Sim_Param sim(argc, argv);
+    const size_t Np = sim.box_opt.par_num;
+    const FTYPE_t a_switch = 1/FTYPE_t(10 + 1);
+    const FTYPE_t a_end = sim.integ_opt.b_out;
+
+    // Zel`dovich approximation until the handover
+    Handover handover;
+    CHECK( run_stage("ZA", sim, handover, sim.integ_opt.b_in, a_switch, 0) == Approx(a_switch) );
+    REQUIRE( handover.size() == Np );
+    const Handover handover_ZA = handover;
+
+    // frozen-potential continues from the handed over particles until the end of the stage
+    CHECK( run_stage("FP", sim, handover, a_switch, a_end, 0) == Approx(a_end) );
+    REQUIRE( handover.size() == Np );
+    const Handover handover_FP = handover;
+
+    // the same particles give the same stage, particles of the first stage at different time give different one
+    handover = handover_ZA;
+    run_stage("FP", sim, handover, a_switch, a_end, 0);
+    for (size_t i = 0; i < Np; i++){
+        for (size_t k = 0; k < 3; k++) CHECK( handover[i].position[k] == Approx(handover_FP[i].position[k]) );
+    }
+
+    handover.clear();
+    run_stage("ZA", sim, handover, sim.integ_opt.b_in, sim.integ_opt.b_in, 0);
+    run_stage("FP", sim, handover, a_switch, a_end, 0);
+    FTYPE_t max_diff = 0;
+    for (size_t i = 0; i < Np; i++) max_diff = std::max(max_diff, get_distance(handover[i].position, handover_FP[i].position, sim.box_opt.mesh_num));
+    CHECK( max_diff > 0.01 );
+
+    // analytic approximation cannot take over particles, unknown approximation is rejected after the first stage
+    handover = handover_ZA;
+    CHECK_THROWS_AS( run_stage("ZA", sim, handover, a_switch, a_end, 0), std::runtime_error );
+    sim.hybrid_opt.apps = {"ZA", "unknown"};
+    sim.hybrid_opt.z_switch = {10};
+    CHECK_THROWS_AS( run_hybrid(sim), std::runtime_error );
+}
@@ -2,6 +2,284 @@
 #include "../test.hpp"
 #include "mod_frozen_potential.cpp"
 
+namespace{
+
+/**
+ * @brief dense clump of particles around the corner of the box to test periodic images of cells
+ */
+std::vector<Particle_v<FTYPE_t>> init_clump(const Sim_Param& sim, const size_t Np = 2000, const FTYPE_t clump = 10)
+{
+    const size_t Nm = sim.box_opt.mesh_num;
+    std::vector<Particle_v<FTYPE_t>> particles(Np);
+    for (size_t i = 0; i < Np; i++)
+    {
+        for (size_t k = 0; k < 3; k++) particles[i].position[k] = clump*(FTYPE_t(rand())/RAND_MAX - 0.5);
+        get_per(particles[i].position, Nm);
+    }
+    return particles;
+}
+
+/// softening of the short range force
+FTYPE_t get_e2(const Sim_Param& sim){ return pow2(sim.box_opt.Ng*0.1); }
+
+Force_Table init_force_table(const Sim_Param& sim){ return Force_Table(sim.app_opt.rs, sim.app_opt.a, get_e2(sim)); }
+
+/**
+ * @brief compare short range force with direct summation over all pairs, total force has to vanish
+ */
+void check_direct_sum(const Sim_Param& sim, const std::vector<Particle_v<FTYPE_t>>& particles, const Chaining_Mesh& chaining_mesh)
+{
+    const size_t Np = particles.size();
+    const size_t Nm = sim.box_opt.mesh_num;
+    const FTYPE_t e2 = get_e2(sim);
+    const FTYPE_t rs2 = pow2(sim.app_opt.rs);
+    for (size_t j = 0; j < Np; j += 20)
+    {
+        const size_t i = chaining_mesh.par_idx[j];
+        Vec_3D<FTYPE_t> force_direct(0., 0., 0.);
+        FTYPE_t force_scale = 0;
+        for (size_t l = 0; l < Np; l++)
+        {
+            const Vec_3D<FTYPE_t> dr_vec = get_sgn_distance(particles[l].position, particles[i].position, Nm);
+            const FTYPE_t dr2 = dr_vec.norm2();
+            if ((dr2 < rs2) && (dr2 != 0))
+            {
+                const FTYPE_t dr = sqrt(dr2);
+                const FTYPE_t f = (force_tot(dr, e2) - force_ref(dr, sim.app_opt.a))/(4*PI);
+                force_direct += dr_vec*(f/dr);
+                force_scale += std::abs(f);
+            }
+        }
+        for (size_t k = 0; k < 3; k++) CHECK( chaining_mesh.par_force[k][j] == Approx(force_direct[k]).margin(1e-4*force_scale) );
+    }
+
+    for (size_t k = 0; k < 3; k++)
+    {
+        FTYPE_t force_sum = 0, force_abs = 0;
+        for (size_t j = 0; j < Np; j++)
+        {
+            force_sum += chaining_mesh.par_force[k][j];
+            force_abs += std::abs(chaining_mesh.par_force[k][j]);
+        }
+        CHECK( force_sum == Approx(0).margin(1e-10*force_abs) );
+    }
+}
+
+template<class T>
+void check_active(T& short_range, const std::vector<Particle_v<FTYPE_t>>& particles, const Force_Table& force_table,
+                  const std::vector<char>& active)
+{
+    short_range.update(particles);
+    force_short(short_range, force_table, 1);
+    const std::vector<FTYPE_t> force_all = short_range.par_force[0];
+    force_short(short_range, force_table, 1, active);
+    for (size_t j = 0; j < particles.size(); j++)
+    {
+        if (active[short_range.par_idx[j]]) CHECK( short_range.par_force[0][j] == Approx(force_all[j]) );
+    }
+}
+} // namespace
+
+TEST_CASE( "UNIT TEST: sorting particles into chaining mesh {Chaining_Mesh::sort_particles}", "[mod_frozen_potential]" )
+{
+    print_unit_msg("sorting particles into chaining mesh {Chaining_Mesh::sort_particles}");
+
+    int argc = 1;
+    const char* const argv[1] = {"test"};
+    Sim_Param sim(argc, argv);
+
+    const size_t Np = 500;
+    const size_t Nm = sim.box_opt.mesh_num;
+    const std::vector<Particle_v<FTYPE_t>> particles = init_clump(sim, Np, Nm);
+
+    Chaining_Mesh chaining_mesh(Np, sim.app_opt.M, sim.app_opt.Hc, Nm, sim.app_opt.rs, 0);
+    chaining_mesh.sort_particles(particles);
+
+    // every particle is exactly once in its own cell
+    std::vector<size_t> visited(Np, 0);
+    const size_t M3 = chaining_mesh.cell_start.size() - 1;
+    CHECK( chaining_mesh.cell_start[0] == 0 );
+    CHECK( chaining_mesh.cell_start[M3] == Np );
+    for (size_t c = 0; c < M3; c++)
+    {
+        REQUIRE( chaining_mesh.cell_start[c] <= chaining_mesh.cell_start[c+1] );
+        for (size_t j = chaining_mesh.cell_start[c]; j < chaining_mesh.cell_start[c+1]; j++)
+        {
+            const size_t i = chaining_mesh.par_idx[j];
+            visited[i]++;
+            CHECK( chaining_mesh.get_cell(particles[i].position) == c );
+            CHECK( chaining_mesh.par_pos[0][j] == particles[i].position[0] );
+        }
+    }
+    for (size_t i = 0; i < Np; i++) CHECK( visited[i] == 1 );
+
+    // every cell has exactly one color
+    size_t num_colored = 0;
+    for (const auto& cells : chaining_mesh.color_cells) num_colored += cells.size();
+    CHECK( num_colored == M3 );
+}
+
+TEST_CASE( "UNIT TEST: short range force from cell pairs {force_short}", "[mod_frozen_potential]" )
+{
+    print_unit_msg("short range force from cell pairs {force_short}");
+
+    int argc = 1;
+    const char* const argv[1] = {"test"};
+    Sim_Param sim(argc, argv);
+
+    const std::vector<Particle_v<FTYPE_t>> particles = init_clump(sim);
+    const size_t Np = particles.size();
+    const size_t Nm = sim.box_opt.mesh_num;
+    const Force_Table force_table = init_force_table(sim);
+    Chaining_Mesh chaining_mesh(Np, sim.app_opt.M, sim.app_opt.Hc, Nm, sim.app_opt.rs, 0);
+    chaining_mesh.sort_particles(particles);
+    force_short(chaining_mesh, force_table, 1);
+    check_direct_sum(sim, particles, chaining_mesh);
+
+    // small chaining meshes where the neighbouring cells are periodic images of each other
+    for (size_t M = 1; M < 3; M++)
+    {
+        Chaining_Mesh small_mesh(Np, M, FTYPE_t(Nm) / M, Nm, sim.app_opt.rs, 0);
+        small_mesh.sort_particles(particles);
+        force_short(small_mesh, force_table, 1);
+        check_direct_sum(sim, particles, small_mesh);
+    }
+}
+
+TEST_CASE( "UNIT TEST: short range force from Verlet lists {Chaining_Mesh::get_verlet_lists, force_short}", "[mod_frozen_potential]" )
+{
+    print_unit_msg("short range force from Verlet lists {Chaining_Mesh::get_verlet_lists, force_short}");
+
+    int argc = 1;
+    const char* const argv[1] = {"test"};
+    Sim_Param sim(argc, argv);
+
+    std::vector<Particle_v<FTYPE_t>> particles = init_clump(sim);
+    const size_t Np = particles.size();
+    const size_t Nm = sim.box_opt.mesh_num;
+    const FTYPE_t skin = 0.4;
+    const Force_Table force_table = init_force_table(sim);
+    const size_t M = size_t(Nm / (sim.app_opt.rs + skin));
+    Chaining_Mesh verlet_mesh(Np, M, FTYPE_t(Nm) / M, Nm, sim.app_opt.rs, skin);
+    Chaining_Mesh chaining_mesh(Np, sim.app_opt.M, sim.app_opt.Hc, Nm, sim.app_opt.rs, 0);
+    REQUIRE( verlet_mesh.use_verlet );
+    CHECK( !verlet_mesh.update_positions(particles) ); // no lists yet
+    verlet_mesh.sort_particles(particles);
+    verlet_mesh.get_verlet_lists();
+
+    // move particles by less than half of the skin, some of them across the box boundary
+    for (size_t i = 0; i < Np; i++)
+    {
+        for (size_t k = 0; k < 3; k++) particles[i].position[k] += 0.2*skin*(FTYPE_t(rand())/RAND_MAX - 0.5);
+        get_per(particles[i].position, Nm);
+    }
+    REQUIRE( verlet_mesh.update_positions(particles) );
+    force_short(verlet_mesh, force_table, 1);
+
+    chaining_mesh.sort_particles(particles);
+    force_short(chaining_mesh, force_table, 1);
+
+    // compare particle by particle, both meshes sort particles by their index within cells
+    std::vector<size_t> j_verlet(Np);
+    for (size_t j = 0; j < Np; j++) j_verlet[verlet_mesh.par_idx[j]] = j;
+    for (size_t j = 0; j < Np; j++)
+    {
+        const size_t i = chaining_mesh.par_idx[j];
+        for (size_t k = 0; k < 3; k++)
+        {
+            CHECK( verlet_mesh.par_force[k][j_verlet[i]] == Approx(chaining_mesh.par_force[k][j]).margin(1e-6) );
+        }
+    }
+
+    // large displacement invalidates lists
+    particles[0].position[0] += skin;
+    get_per(particles[0].position, Nm);
+    CHECK( !verlet_mesh.update_positions(particles) );
+}
+
+TEST_CASE( "UNIT TEST: short range force from octree {Octree::build_tree, force_short}", "[mod_frozen_potential]" )
+{
+    print_unit_msg("short range force from octree {Octree::build_tree, force_short}");
+
+    int argc = 1;
+    const char* const argv[1] = {"test"};
+    Sim_Param sim(argc, argv);
+
+    const std::vector<Particle_v<FTYPE_t>> particles = init_clump(sim);
+    const size_t Np = particles.size();
+    const size_t Nm = sim.box_opt.mesh_num;
+    const Force_Table force_table = init_force_table(sim);
+    Chaining_Mesh chaining_mesh(Np, sim.app_opt.M, sim.app_opt.Hc, Nm, sim.app_opt.rs, 0);
+    chaining_mesh.update(particles);
+    force_short(chaining_mesh, force_table, 1);
+    std::vector<size_t> j_mesh(Np);
+    for (size_t j = 0; j < Np; j++) j_mesh[chaining_mesh.par_idx[j]] = j;
+
+    for (FTYPE_t theta : {0., 0.5})
+    {
+        Octree octree(Np, Nm, sim.app_opt.rs, theta);
+        octree.update(particles);
+
+        // particles are sorted along Morton curve, every node contains its children
+        FTYPE_t mass = 0;
+        for (size_t j = 1; j < Np; j++) REQUIRE( octree.par_key[j-1] <= octree.par_key[j] );
+        for (const Octree::Node& node : octree.nodes)
+        {
+            if (!node.num_child) mass += node.mass;
+            for (size_t c = node.first_child; c < node.first_child + node.num_child; c++)
+            {
+                CHECK( octree.nodes[c].first >= node.first );
+                CHECK( octree.nodes[c].first + octree.nodes[c].num <= node.first + node.num );
+                CHECK( octree.nodes[c].level == node.level + 1 );
+            }
+        }
+        CHECK( octree.nodes[0].mass == Approx(Np) );
+        CHECK( mass == Approx(Np) );
+
+        // exact force when every node is opened, approximate otherwise
+        force_short(octree, force_table, 1);
+        FTYPE_t err = 0, norm = 0;
+        for (size_t j = 0; j < Np; j++)
+        {
+            const size_t j_2 = j_mesh[octree.par_idx[j]];
+            for (size_t k = 0; k < 3; k++)
+            {
+                err += pow2(octree.par_force[k][j] - chaining_mesh.par_force[k][j_2]);
+                norm += pow2(chaining_mesh.par_force[k][j_2]);
+            }
+        }
+        if (theta == 0) CHECK( sqrt(err/norm) < 1e-6 );
+        else CHECK( sqrt(err/norm) < 0.01 );
+    }
+}
+
+TEST_CASE( "UNIT TEST: short range force of active particles {force_short}", "[mod_frozen_potential]" )
+{
+    print_unit_msg("short range force of active particles {force_short}");
+
+    int argc = 1;
+    const char* const argv[1] = {"test"};
+    Sim_Param sim(argc, argv);
+
+    const std::vector<Particle_v<FTYPE_t>> particles = init_clump(sim);
+    const size_t Np = particles.size();
+    const size_t Nm = sim.box_opt.mesh_num;
+    std::vector<char> active(Np);
+    for (size_t i = 0; i < Np; i++) active[i] = (rand() % 10 == 0);
+
+    const Force_Table force_table = init_force_table(sim);
+    const FTYPE_t skin = 0.4;
+    const size_t M = size_t(Nm / (sim.app_opt.rs + skin));
+    Chaining_Mesh chaining_mesh(Np, sim.app_opt.M, sim.app_opt.Hc, Nm, sim.app_opt.rs, 0);
+    Chaining_Mesh verlet_mesh(Np, M, FTYPE_t(Nm) / M, Nm, sim.app_opt.rs, skin);
+    Octree octree(Np, Nm, sim.app_opt.rs, 0);
+
+    // forces of active particles do not depend on other particles being active
+    check_active(chaining_mesh, particles, force_table, active);
+    check_active(verlet_mesh, particles, force_table, active);
+    check_active(octree, particles, force_table, active);
+}
+
 // void force_test(Sim_Param& sim)
 // {
 //     // 1 particle prep
@@ -0,0 +1,33 @@
+#include <catch.hpp>
+#include "test.hpp"
+#include "core_app.cpp"
+
+TEST_CASE( "UNIT TEST: fraction of shell-crossed particles {get_shell_cross_frac}", "[core]" )
+{
+    print_unit_msg("fraction of shell-crossed particles {get_shell_cross_frac}");
+
+    int argc = 1;
+    const char* const argv[1] = {"test"};
+    Sim_Param sim(argc, argv);
+
+    // particles on unperturbed lattice
+    const size_t n = sim.box_opt.par_num_1d;
+    const size_t Np = sim.box_opt.par_num;
+    const size_t Nm = sim.box_opt.mesh_num;
+    const FTYPE_t Ng = sim.box_opt.Ng;
+    std::vector<Particle_x<FTYPE_t>> particles(Np);
+    for (size_t i = 0; i < Np; i++) particles[i].position = Vec_3D<FTYPE_t>(FTYPE_t(i / (n*n)), FTYPE_t((i / n) % n), FTYPE_t(i % n))*Ng;
+    CHECK( get_shell_cross_frac(particles, sim) == 0 );
+
+    // uniform shift across the periodic boundary does not cross any shells
+    for (auto& particle : particles)
+    {
+        particle.position[0] += Nm - Ng/2;
+        get_per(particle.position, Nm);
+    }
+    CHECK( get_shell_cross_frac(particles, sim) == 0 );
+
+    // one particle overtakes its neighbour along 'x'
+    particles[(n + 1)*n + 1].position[0] += FTYPE_t(1.5)*Ng;
+    CHECK( get_shell_cross_frac(particles, sim) == Approx(FTYPE_t(1)/Np) );
+}
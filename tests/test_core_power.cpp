@@ -27,4 +27,24 @@ TEST_CASE( "UNIT TEST: growth functions {growth_factor, growth_rate, growth_chan
     catch(const std::exception& e){
 		std::cout << "Error: " << e.what() << "\n";
     }
-}
\ No newline at end of file
+}
+TEST_CASE( "UNIT TEST: second-order growth functions {growth_factor_2, growth_change_2}", "[core_power]" )
+{
+    print_unit_msg("second-order growth functions {growth_factor_2, growth_change_2}");
+
+    int argc = 1;
+    const char* const argv[1] = {"test"};
+    Sim_Param sim(argc, argv);
+
+    // matter domination, D_2 = -3/7 D^2
+    const FTYPE_t a_early = 0.01;
+    CHECK( growth_factor_2(a_early, sim.cosmo) == Approx(-3/7.*pow2(growth_factor(a_early, sim.cosmo))).epsilon(1e-3) );
+
+    // derivative compared with finite difference
+    const FTYPE_t h = 1e-4;
+    for (FTYPE_t a = 0.1; a <= 1.0; a += 0.3)
+    {
+        const FTYPE_t dD2da = (growth_factor_2(a + h, sim.cosmo) - growth_factor_2(a - h, sim.cosmo))/(2*h);
+        CHECK( growth_change_2(a, sim.cosmo) == Approx(dD2da).epsilon(1e-2) );
+    }
+}
@@ -0,0 +1,140 @@
+#include <catch.hpp>
+#include "test.hpp"
+#include "integration.cpp" ///< implementation testing
+#include "core_power.h"
+
+TEST_CASE( "UNIT TEST: integrated kick & stream factors {Integ_Coeff}", "[integration]" )
+{
+    print_unit_msg("integrated kick & stream factors {Integ_Coeff}");
+
+    int argc = 1;
+    const char* const argv[1] = {"test"};
+    Sim_Param sim(argc, argv);
+    sim.integ_opt.fastpm = true;
+
+    // uniform displacement field, Zel`dovich solution: x = q + D*u, v = dD/da*u
+    const size_t N = 8;
+    const FTYPE_t u = 0.1;
+    const FTYPE_t x_c = N/2.;
+    std::vector<Mesh> force_field;
+    for(size_t i = 0; i < 3; i++){
+        force_field.emplace_back(N);
+        force_field[i].assign(i ? 0 : u);
+    }
+
+    // one large time-step
+    const FTYPE_t a_0 = 0.1, da = 0.5;
+    std::vector<Particle_v<FTYPE_t>> particles(1);
+    particles[0].position = Vec_3D<FTYPE_t>(x_c + growth_factor(a_0, sim.cosmo)*u, x_c, x_c);
+    particles[0].velocity = Vec_3D<FTYPE_t>(growth_change(a_0, sim.cosmo)*u, FTYPE_t(0), FTYPE_t(0));
+
+    const Integ_Coeff coeff(sim, a_0 + da, da);
+    CHECK( coeff.a_half == Approx(a_0 + da/2) );
+    symplectic_step(sim, a_0 + da, da, particles, [&](const Integ_Coeff& c){ kick_step_w_momentum(c, particles, force_field); }, N);
+
+    CHECK( particles[0].position[0] == Approx(x_c + growth_factor(a_0 + da, sim.cosmo)*u) );
+    CHECK( particles[0].velocity[0] == Approx(growth_change(a_0 + da, sim.cosmo)*u) );
+    CHECK( particles[0].position[1] == Approx(x_c) );
+    CHECK( particles[0].velocity[1] == Approx(0) );
+}
+
+TEST_CASE( "UNIT TEST: higher-order integrators {Symplectic_Integ, runge_kutta_no_momentum}", "[integration]" )
+{
+    print_unit_msg("higher-order integrators {Symplectic_Integ, runge_kutta_no_momentum}");
+
+    int argc = 1;
+    const char* const argv[1] = {"test"};
+    Sim_Param sim(argc, argv);
+    sim.integ_opt.fastpm = false;
+
+    // uniform displacement field, Zel`dovich solution: x = q + D*u, v = dD/da*u
+    const size_t N = 8;
+    const FTYPE_t u = 0.1;
+    const FTYPE_t x_c = N/2.;
+    std::vector<Mesh> force_field;
+    for(size_t i = 0; i < 3; i++){
+        force_field.emplace_back(N);
+        force_field[i].assign(i ? 0 : u);
+    }
+
+    const FTYPE_t a_0 = 0.5, da = 0.1, a_1 = a_0 + da;
+    const FTYPE_t x_exact = x_c + growth_factor(a_1, sim.cosmo)*u;
+    auto init_particles = [&](std::vector<Particle_v<FTYPE_t>>& particles)
+    {
+        particles[0].position = Vec_3D<FTYPE_t>(x_c + growth_factor(a_0, sim.cosmo)*u, x_c, x_c);
+        particles[0].velocity = Vec_3D<FTYPE_t>(growth_change(a_0, sim.cosmo)*u, FTYPE_t(0), FTYPE_t(0));
+    };
+    // Yoshida is more accurate than Leapfrog
+    std::vector<Particle_v<FTYPE_t>> par_2(1), par_4(1);
+    init_particles(par_2);
+    init_particles(par_4);
+    auto kick_2 = [&](const Integ_Coeff& coeff){ kick_step_w_momentum(coeff, par_2, force_field); };
+    auto kick_4 = [&](const Integ_Coeff& coeff){ kick_step_w_momentum(coeff, par_4, force_field); };
+    Symplectic_Integ<2>::step(sim, a_1, da, par_2, kick_2, N);
+    sim.integ_opt.order = 4;
+    Symplectic_Integ<4>::step(sim, a_1, da, par_4, kick_4, N);
+    CHECK( std::abs(par_4[0].position[0] - x_exact) < std::abs(par_2[0].position[0] - x_exact) );
+
+    // Runge-Kutta for streamlines, velocity at the end of the time-step is exact
+    std::vector<Particle_v<FTYPE_t>> par_rk(1);
+    init_particles(par_rk);
+    runge_kutta_no_momentum(sim.cosmo, a_1, da, par_rk, force_field, N);
+    CHECK( par_rk[0].position[0] == Approx(x_exact).epsilon(1e-4) );
+    CHECK( par_rk[0].velocity[0] == Approx(growth_change(a_1, sim.cosmo)*u) );
+
+    // Runge-Kutta does not use stored velocity, e.g. after hybrid handover
+    init_particles(par_rk);
+    par_rk[0].velocity.fill(0.);
+    runge_kutta_no_momentum(sim.cosmo, a_1, da, par_rk, force_field, N);
+    CHECK( par_rk[0].position[0] == Approx(x_exact).epsilon(1e-4) );
+
+    // first time-step from default 'z = 200' with 'time_step = 0.1', middle step of Yoshida integrator would reach
+    // negative scale factor, Leapfrog step is done instead
+    CHECK_NOTHROW( sim.integ_opt.init() );
+    const FTYPE_t a_in = sim.integ_opt.b_in, db = sim.integ_opt.db;
+    init_particles(par_2);
+    init_particles(par_4);
+    Symplectic_Integ<2>::step(sim, a_in + db, db, par_2, kick_2, N); // with time-symmetric kick of 'order = 4'
+    Symplectic_Integ<4>::step(sim, a_in + db, db, par_4, kick_4, N);
+    CHECK( par_4[0].position[0] == Approx(par_2[0].position[0]) );
+    CHECK( par_4[0].velocity[0] == Approx(par_2[0].velocity[0]) );
+}
+
+TEST_CASE( "UNIT TEST: fused single-pass update {stream_kick_stream_fused, Frozen_Force_Kick}", "[integration]" )
+{
+    print_unit_msg("fused single-pass update {stream_kick_stream_fused, Frozen_Force_Kick}");
+
+    int argc = 1;
+    const char* const argv[1] = {"test"};
+    Sim_Param sim(argc, argv);
+
+    // non-uniform force field
+    const size_t N = 8;
+    std::vector<Mesh> force_field;
+    for(size_t i = 0; i < 3; i++){
+        force_field.emplace_back(N);
+        for(size_t j = 0; j < force_field[i].length; j++) force_field[i][j] = sin(0.1*(i+1)*j);
+    }
+
+    // fused and separate passes give the same result, also across periodic boundary
+    std::vector<Particle_v<FTYPE_t>> par_fused(2), par_sep(2);
+    for(auto particles : {&par_fused, &par_sep}){
+        (*particles)[0] = Particle_v<FTYPE_t>(Vec_3D<FTYPE_t>(1.3, 2.7, 5.1), Vec_3D<FTYPE_t>(0.5, -0.2, 1.));
+        (*particles)[1] = Particle_v<FTYPE_t>(Vec_3D<FTYPE_t>(7.9, 0.1, 3.3), Vec_3D<FTYPE_t>(2., -3., 0.4));
+    }
+
+    const FTYPE_t a = 0.5, da = 0.1;
+    Frozen_Force_Kick kick_fused(force_field);
+    auto kick_sep = [&](const Integ_Coeff& coeff){ kick_step_w_momentum(coeff, par_sep, force_field); };
+    symplectic_step(sim, a, da, par_fused, kick_fused, N);
+    symplectic_step(sim, a, da, par_sep, kick_sep, N);
+
+    for(size_t i = 0; i < 2; i++){
+        for(size_t j = 0; j < 3; j++){
+            CHECK( par_fused[i].position[j] == Approx(par_sep[i].position[j]) );
+            CHECK( par_fused[i].velocity[j] == Approx(par_sep[i].velocity[j]) );
+            CHECK( par_fused[i].position[j] >= 0 );
+            CHECK( par_fused[i].position[j] < N );
+        }
+    }
+}